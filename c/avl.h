@@ -74,8 +74,11 @@ typedef struct avl_node_t {
      * This point is attained by 'set' and by the same sets that attains its promoter. It is also
      * attained by any set that attains its remover. It is also attained by every set that attains
      * any point equal to itself.
+     * id - index of the node, so that each node is visited once when
+     *      determining the attainment indicators.
      */
     int set;
+    int id;
     struct avl_node_t *promoter;
     struct avl_node_t *remover;
     struct avl_node_t *equal;
@@ -81,6 +81,57 @@ bit_array_set(bit_array * b, size_t i, bool x) {
 }
 
 
+/* Number of bits set in a word.  With -march=native on hardware with
+   POPCNT (or AVX512-VPOPCNTDQ, when the loop in bit_array_count_range() is
+   vectorized), the builtin becomes a single instruction.  */
+static inline unsigned int
+bit_word_popcount(bit_array_word_t w)
+{
+#if defined(__GNUC__) || defined(__clang__)
+    return (unsigned int) __builtin_popcountll(w);
+#else
+    w = w - ((w >> 1) & UINT64_C(0x5555555555555555));
+    w = (w & UINT64_C(0x3333333333333333)) + ((w >> 2) & UINT64_C(0x3333333333333333));
+    w = (w + (w >> 4)) & UINT64_C(0x0f0f0f0f0f0f0f0f);
+    return (unsigned int) ((w * UINT64_C(0x0101010101010101)) >> 56);
+#endif
+}
+
+/* Number of bits set within positions [from, to).  */
+static inline size_t
+bit_array_count_range(const bit_array * b, size_t from, size_t to)
+{
+    if (from >= to) return 0;
+    size_t first = bitset_word(b, from);
+    size_t last = bitset_word(b, to - 1);
+    bit_array_word_t first_mask = ~(bit_array_word_t)0 << bitset_index(b, from);
+    bit_array_word_t last_mask = ~(bit_array_word_t)0
+        >> (bit_array_word_size - 1 - bitset_index(b, to - 1));
+    if (first == last)
+        return bit_word_popcount(b[first] & first_mask & last_mask);
+
+    size_t count = bit_word_popcount(b[first] & first_mask);
+    for (size_t i = first + 1; i < last; i++)
+        count += bit_word_popcount(b[i]);
+    return count + bit_word_popcount(b[last] & last_mask);
+}
+
+/* Set bit k of b iff x[k] != 0, for k in [0, n). Whole words are written at
+   once, so unused bits of the last word are cleared.  */
+static inline void
+bit_array_set_from_int(bit_array * restrict b, const int * restrict x, size_t n)
+{
+    size_t nwords = bit_nwords(n);
+    for (size_t i = 0; i < nwords; i++) {
+        size_t start = i * bit_array_word_size;
+        size_t end = MIN(start + bit_array_word_size, n);
+        bit_array_word_t w = 0;
+        for (size_t k = start; k < end; k++)
+            w |= (bit_array_word_t)(x[k] != 0) << (k - start);
+        b[i] = w;
+    }
+}
+
 static inline void
 bitset_check(const bit_array * restrict b, const bool * restrict ref, size_t n)
 {
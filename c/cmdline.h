@@ -24,9 +24,15 @@
     "     --maximise      all objectives must be maximised;\n"
 #define OPTION_NOCHECK_STR \
     "     --no-check      do not check nondominance of sets (faster but unsafe);\n"
+#define OPTION_JOBS_STR \
+    " -j, --jobs=N        process up to N input files or sets in parallel.     \n" \
+    "                     The output does not depend on N. Default is 1.       \n" \
+    "                     With N > 1, whole input files are read into memory.  \n"
 
 #include <stdbool.h>
 #include <ctype.h> // for isspace()
+#include <limits.h> // for INT_MAX
+#include <errno.h>
 
 extern char *program_invocation_short_name;
 
@@ -158,7 +164,6 @@ data_bounds(double **minimum_p, double **maximum_p,
             const double *data, int nobj, int rows)
 {
     ASSUME(nobj > 1);
-    ASSUME(nobj <= 32);
     int k;
 
     double * minimum = *minimum_p;
@@ -176,14 +181,45 @@ data_bounds(double **minimum_p, double **maximum_p,
         *maximum_p = maximum;
     }
 
-    for (int r = 0, n = 0; r < rows; r++) {
-        for (k = 0; k < nobj; k++, n++) {
-            if (maximum[k] < data[n])
-                maximum[k] = data[n];
-            if (minimum[k] > data[n])
-                minimum[k] = data[n];
+    /* Reduce blocks of as many rows as fit in DATA_BOUNDS_LEN values
+       element-wise, which the compiler can vectorize for any NOBJ, then reduce
+       the rows of the block.  If a single row does not fit, there are no
+       blocks and all rows are handled below.  */
+#define DATA_BOUNDS_LEN 256
+    double lo[DATA_BOUNDS_LEN], hi[DATA_BOUNDS_LEN];
+    const size_t block_rows = DATA_BOUNDS_LEN / (size_t) nobj;
+    const size_t len = (size_t) nobj * block_rows;
+    const size_t nblocks = (block_rows == 0) ? 0 : (size_t) rows / block_rows;
+    for (size_t j = 0; j < len; j++) {
+        lo[j] = INFINITY;
+        hi[j] = -INFINITY;
+    }
+    for (size_t b = 0; b < nblocks; b++) {
+        const double * x = data + b * len;
+#ifdef _OPENMP
+#pragma omp simd
+#endif
+        for (size_t j = 0; j < len; j++) {
+            lo[j] = (x[j] < lo[j]) ? x[j] : lo[j];
+            hi[j] = (x[j] > hi[j]) ? x[j] : hi[j];
         }
     }
+    for (size_t j = 0; j < len; j++) {
+        k = (int) (j % (size_t) nobj);
+        if (minimum[k] > lo[j])
+            minimum[k] = lo[j];
+        if (maximum[k] < hi[j])
+            maximum[k] = hi[j];
+    }
+#undef DATA_BOUNDS_LEN
+    /* Remaining rows.  */
+    for (size_t n = nblocks * len; n < (size_t) nobj * rows; n++) {
+        k = (int) (n % (size_t) nobj);
+        if (maximum[k] < data[n])
+            maximum[k] = data[n];
+        if (minimum[k] > data[n])
+            minimum[k] = data[n];
+    }
 }
 
 _attr_maybe_unused static void
@@ -201,6 +237,135 @@ file_bounds (const char *filename, double **maximum_p, double **minimum_p,
     free(cumsizes);
 }
 
+static inline int
+parse_cmdline_jobs(const char *optarg)
+{
+    char *endp;
+    long int value = strtol(optarg, &endp, 10);
+    if (endp == optarg || *endp != '\0' || value <= 0 || value > INT_MAX)
+        fatal_error("value of --jobs must be a positive integer '%s'", optarg);
+    return (int) value;
+}
+
+/* An input file of a tool that processes several files with --jobs.  */
+typedef struct {
+    const char *filename; // NULL means stdin.
+    double *data;
+    int *cumsizes;
+    int nruns;
+    int err;       // Return value of read_double_data().
+    int first_set; // Index of its first set, see input_files_sets().
+    double *minimum, *maximum; // See read_input_files().
+} input_file_t;
+
+static void
+read_input_file(input_file_t *file, int *nobj_p, bool bounds)
+{
+    file->err = read_double_data(file->filename, &file->data, nobj_p,
+                                 &file->cumsizes, &file->nruns);
+    if (bounds && file->err == 0)
+        data_bounds(&file->minimum, &file->maximum, file->data, *nobj_p,
+                    file->cumsizes[file->nruns - 1]);
+}
+
+/* Read NFILES input files using up to NTHREADS threads.  If *NOBJ_P is zero,
+   it is taken from the first file, which is read before the others, so the
+   number of objectives of every file is checked as if the files were read
+   one after another.  If BOUNDS is true, the minimum and maximum of each
+   file are calculated by the thread that read it.  Errors are not handled
+   here: the caller must call handle_read_data_error() on each file in
+   order.  */
+_attr_maybe_unused static void
+read_input_files(input_file_t *files, int nfiles, int *nobj_p, bool bounds,
+                 int nthreads)
+{
+    int start = 0;
+    if (*nobj_p == 0 && nfiles > 0) {
+        read_input_file(&files[0], nobj_p, bounds);
+        start = 1;
+    }
+    const int nobj = *nobj_p;
+    if (nthreads < 1) nthreads = 1;
+#ifdef _OPENMP
+#pragma omp parallel for schedule(dynamic, 1) num_threads(nthreads) if (nthreads > 1 && nfiles - start > 1)
+#endif
+    for (int k = start; k < nfiles; k++) {
+        int file_nobj = nobj;
+        read_input_file(&files[k], &file_nobj, bounds);
+    }
+}
+
+/* Number the sets of all files that were read without error and return an
+   array that maps the index of each set to the index of its file.  The
+   index of set N of file K is FILES[K].first_set + N.  */
+_attr_maybe_unused static int *
+input_files_sets(input_file_t *files, int nfiles, int *nsets_p)
+{
+    int nsets = 0;
+    for (int k = 0; k < nfiles; k++) {
+        files[k].first_set = nsets;
+        if (files[k].err == 0)
+            nsets += files[k].nruns;
+    }
+    int *set_file = malloc(sizeof(int) * (size_t) MAX(nsets, 1));
+    for (int k = 0; k < nfiles; k++) {
+        if (files[k].err != 0)
+            continue;
+        for (int n = 0; n < files[k].nruns; n++)
+            set_file[files[k].first_set + n] = k;
+    }
+    *nsets_p = nsets;
+    return set_file;
+}
+
+/* Open FILENAME for reading one set at a time.  Errors are handled as in
+   handle_read_data_error().  */
+_attr_maybe_unused static dataset_reader_t *
+open_dataset_reader(const char *filename)
+{
+    dataset_reader_t *reader;
+    handle_read_data_error(dataset_reader_open(&reader, filename), filename);
+    return reader;
+}
+
+/* Read the next set of READER into *DATA_P and *SIZE_P.  Returns false at
+   the end of the input.  Errors are handled as in handle_read_data_error().  */
+_attr_maybe_unused static bool
+read_next_set(dataset_reader_t *reader, const char *filename,
+              const double **data_p, int *nobj_p, int *size_p)
+{
+    int result = dataset_reader_next_set(reader, data_p, nobj_p, size_p);
+    if (result < 0)
+        handle_read_data_error(result, filename);
+    return result > 0;
+}
+
+/* The tools that read one set at a time keep the results of each set in a
+   vector_double until the whole file has been read.  */
+#include "cvector.h"
+vector_define(vector_double, double)
+
+/* Number of input files to read at once, out of NFILES, so that NTHREADS
+   threads are kept busy without reading all files into memory.  */
+static inline int
+input_files_batch(int nfiles, int nthreads)
+{
+    if (nthreads <= 1)
+        return 1;
+    return (nthreads < nfiles / 4) ? 4 * nthreads : nfiles;
+}
+
+_attr_maybe_unused static void
+input_files_free(input_file_t *files, int nfiles)
+{
+    for (int k = 0; k < nfiles; k++) {
+        free(files[k].data);
+        free(files[k].cumsizes);
+        free(files[k].minimum);
+        free(files[k].maximum);
+    }
+}
+
 static inline char * m_strcat(const char * a, const char * b)
 {
     size_t dest_len = strlen(a) + strlen(b) + 1;
@@ -212,6 +377,36 @@ static inline char * m_strcat(const char * a, const char * b)
     return dest;
 }
 
+/* Open the output file for input FILENAME, which is FILENAME followed by
+   SUFFIX, or return stdout if SUFFIX is NULL or FILENAME is stdin_name.  */
+static inline FILE *
+open_output_file(const char *filename, const char *suffix, char **outfilename_p)
+{
+    *outfilename_p = NULL;
+    if (filename == stdin_name || !suffix)
+        return stdout;
+    char *outfilename = m_strcat(filename, suffix);
+    FILE *outfile = fopen (outfilename, "w");
+    if (outfile == NULL) {
+        errprintf ("%s: %s\n", outfilename, strerror(errno));
+        exit (EXIT_FAILURE);
+    }
+    *outfilename_p = outfilename;
+    return outfile;
+}
+
+static inline void
+close_output_file(FILE *outfile, const char *filename, char *outfilename,
+                  bool verbose)
+{
+    if (!outfilename)
+        return;
+    if (verbose)
+        fprintf (stderr, "# %s -> %s\n", filename, outfilename);
+    fclose (outfile);
+    free (outfilename);
+}
+
 static inline const char *str_is_default(bool flag)
 {
     return flag ? "(default)" : "";
@@ -151,6 +151,12 @@ BASE_TYPE VECTOR_TYPE##_pop_back(VECTOR_TYPE * v)                              \
     return *(v->_end);                                                         \
 }                                                                              \
                                                                                \
+/* Removes all elements from the vector (which are not freed), leaving
+   it with a size of zero.  The capacity is not changed. */                   \
+static inline                                                                 \
+void VECTOR_TYPE##_clear(VECTOR_TYPE * v)                                     \
+{ v->_end = v->_begin; }                                                      \
+                                                                              \
 /* Returns the first element in the vector container.  This is not a
    reference like in C++! */                                                   \
 static inline                                                                  \
@@ -51,17 +51,21 @@ static int compare_y_desc (const void *p1, const void *p2)
 }
 
 static void
-point2d_printf(FILE *stream, const objective_t x, const objective_t y)
+point2d_printf(outbuf_t *out, const objective_t x, const objective_t y)
 {
-    fprintf(stream, point_printf_format point_printf_sep point_printf_format, x, y);
+    outbuf_point (out, x);
+    outbuf_puts (out, point_printf_sep);
+    outbuf_point (out, y);
 }
 
 static void
-point_printf(FILE *stream, const objective_t *p, int nobj)
+point_printf(outbuf_t *out, const objective_t *p, int nobj)
 {
-    point2d_printf(stream, p[0], p[1]);
-    for (int k = 2; k < nobj; k++)
-        fprintf (stream, point_printf_sep point_printf_format, p[k]);
+    point2d_printf(out, p[0], p[1]);
+    for (int k = 2; k < nobj; k++) {
+        outbuf_puts (out, point_printf_sep);
+        outbuf_point (out, p[k]);
+    }
 }
 
 eaf_t * eaf_create (int nobj, int nruns, int npoints)
@@ -122,10 +126,8 @@ eaf_store_point_help (eaf_t * eaf, int nobj,
         // FIXME: We could save memory by only storing eaf->attained per point if requested.
         eaf_realloc(eaf, nobj);
     }
-    // FIXME: provide a bit_array function to do this.
-    for (int k = 0; k < nruns; k++) {
-        bit_array_set(bit_array_offset(eaf->bit_attained, eaf->size, nruns), k, (bool) save_attained[k]);
-    }
+    bit_array_set_from_int(bit_array_offset(eaf->bit_attained, eaf->size, nruns),
+                           save_attained, nruns);
     return eaf->data + nobj * eaf->size;
 }
 
@@ -150,41 +152,48 @@ eaf_store_point_2d (eaf_t * eaf, objective_t x, objective_t y,
     eaf->size++;
 }
 
-static void
-eaf_print_line (FILE *coord_file, FILE *indic_file, FILE *diff_file,
+void
+eaf_print_line (outbuf_t *coord_file, outbuf_t *indic_file, outbuf_t *diff_file,
                 const objective_t *x, int nobj,
                 const bit_array *attained, int nruns)
 {
     if (coord_file) {
         point_printf(coord_file, x, nobj);
-        fprintf (coord_file,
-                 (coord_file == indic_file) || (coord_file == diff_file)
-                 ? "\t" : "\n");
+        outbuf_putc (coord_file,
+                     (coord_file == indic_file) || (coord_file == diff_file)
+                     ? '\t' : '\n');
     }
 
     int k, count1 = 0, count2 = 0;
     if (indic_file) {
-        fprintf (indic_file, "%d",
-                 bit_array_get(attained, 0) ? (count1++,1) : 0);
-        for (k = 1; k < nruns/2; k++)
-            fprintf (indic_file, " %d",
-                     bit_array_get(attained, k) ? (count1++,1) : 0);
-        for (k = nruns/2; k < nruns; k++)
-            fprintf (indic_file, " %d",
-                     bit_array_get(attained, k) ? (count2++,1) : 0);
-
-        fprintf (indic_file, (indic_file == diff_file) ? "\t" : "\n");
+        for (k = 0; k < nruns; k++) {
+            bool b = bit_array_get(attained, k);
+            if (k < nruns/2)
+                count1 += b;
+            else
+                count2 += b;
+            if (k > 0)
+                outbuf_putc (indic_file, ' ');
+            outbuf_putc (indic_file, b ? '1' : '0');
+        }
+        outbuf_putc (indic_file, (indic_file == diff_file) ? '\t' : '\n');
     } else if (diff_file) {
         attained_left_right(attained, nruns/2, nruns, &count1, &count2);
     }
 
-    if (diff_file)
-        fprintf (diff_file,"%d %d\n", count1, count2);
+    if (diff_file) {
+        outbuf_int (diff_file, count1);
+        outbuf_putc (diff_file, ' ');
+        outbuf_int (diff_file, count2);
+        outbuf_putc (diff_file, '\n');
+    }
 }
 
-/* Print one attainment surface of the EAF.  */
+/* Print one attainment surface of the EAF.  Outputs that go to the same
+   stream must use the same outbuf_t.  */
 void
-eaf_print_attsurf (const eaf_t * eaf, int nobj, FILE *coord_file,  FILE *indic_file, FILE *diff_file)
+eaf_print_attsurf (const eaf_t * eaf, int nobj, outbuf_t *coord_file,
+                   outbuf_t *indic_file, outbuf_t *diff_file)
 {
     for (size_t i = 0; i < eaf->size; i++) {
         const objective_t *p = eaf->data + i * nobj;
@@ -241,12 +250,43 @@ eaf2matrix (double *rmat, eaf_t * const * eaf, int nobj, _attr_maybe_unused int
     }
 }
 
+struct eaf_matrix_stream {
+    vector_objective mat;
+    const double * percentile;
+    int nlevels;
+};
+
+static void
+eaf2d_matrix_callback (void *arg, int l, const objective_t *p,
+                       _attr_maybe_unused const int *attained)
+{
+    struct eaf_matrix_stream * s = (struct eaf_matrix_stream *) arg;
+    if (p == NULL) return;
+    vector_objective_push_back(&s->mat, p[0]);
+    vector_objective_push_back(&s->mat, p[1]);
+    vector_objective_push_back(&s->mat, s->percentile
+                               ? s->percentile[l]
+                               : level2percentile(l + 1, s->nlevels));
+}
+
 double *
-eaf_compute_matrix(int *eaf_npoints, double * data, int nobj, const int *cumsizes, int nruns,
+eaf_compute_matrix(int *eaf_npoints, const double * data, int nobj, const int *cumsizes, int nruns,
                    const double * percentile, int nlevels)
 {
     int *level = levels_from_percentiles(percentile, nlevels, nruns);
-    eaf_t **eaf = attsurf(data, nobj, cumsizes, nruns, level, nlevels);
+    if (nobj == 2) {
+        /* The attainment indicators are not needed, so stream the points
+           directly into the result matrix.  */
+        struct eaf_matrix_stream s = { .percentile = percentile,
+                                       .nlevels = nlevels };
+        vector_objective_ctor (&s.mat, 3 * (size_t) (256 + cumsizes[nruns - 1]));
+        eaf2d_stream (data, cumsizes, nruns, level, nlevels,
+                      eaf2d_matrix_callback, &s);
+        free (level);
+        *eaf_npoints = (int) (vector_objective_size(&s.mat) / 3);
+        return vector_objective_begin(&s.mat);
+    }
+    eaf_t **eaf = attsurf(data, nobj, cumsizes, nruns, level, nlevels, 1);
     free (level);
 
     int totalpoints = eaf_totalpoints (eaf, nlevels);
@@ -258,8 +298,8 @@ eaf_compute_matrix(int *eaf_npoints, double * data, int nobj, const int *cumsize
 }
 
 /*
-   eaf2d: compute attainment surfaces from points in objective space,
-          using dimension sweeping.
+   eaf2d_stream: compute attainment surfaces from points in objective space,
+                 using dimension sweeping, without storing them.
 
    Input arguments:
         data : a pointer to the data matrix, stored as a linear array of
@@ -269,18 +309,22 @@ eaf_compute_matrix(int *eaf_npoints, double * data, int nobj, const int *cumsize
         nruns :	the number of independent non-dominated fronts.
         attlevel : an array containing the attainment levels to compute.
         nlevel : number of attainment levels to compute.
-        coord_file  : stream to write the resulting attainment surfaces.
-        indic_file  : stream to write the resulting attainment indices.
-        diff_file   : stream to write the difference between the the
-                      first half and the second half of nruns.
+        callback : function called with each point of the attainment surface
+                   as soon as it is found. The points of each level are
+                   reported in order of increasing x. After the last point
+                   of level l, it is called once more with point == NULL.
+        arg : opaque pointer passed to callback.
+
+   The memory required is proportional to the size of the input and does
+   not depend on the number of levels or the size of the output.
 */
 
-eaf_t **
-eaf2d (const objective_t *data, const int *cumsize, int nruns,
-       const int *attlevel, const int nlevels)
+void
+eaf2d_stream (const objective_t *data, const int *cumsize, int nruns,
+              const int *attlevel, const int nlevels,
+              eaf_callback_t callback, void *arg)
 {
     const int nobj = 2;
-    eaf_t **eaf;
     const objective_t **datax, **datay; /* used to access the data sorted
                                            according to x or y */
 
@@ -340,10 +384,8 @@ eaf2d (const objective_t *data, const int *cumsize, int nruns,
 
     attained = malloc (nruns * sizeof(int));
     save_attained = malloc (nruns * sizeof(int));
-    eaf = malloc(nlevels * sizeof(eaf_t*));
 
     for (l = 0; l < nlevels; l++) {
-        eaf[l] = eaf_create (nobj, nruns, ntotal);
         int level = attlevel[l];
         int x = 0;
         int y = 0;
@@ -403,21 +445,56 @@ eaf2d (const objective_t *data, const int *cumsize, int nruns,
 
             assert (nattained < level);
 
-            eaf_store_point_2d (eaf[l], datax[x][0], datay[y - 1][1],
-                                save_attained);
+            const objective_t point[2] = { datax[x][0], datay[y - 1][1] };
+            callback (arg, l, point, save_attained);
 
         } while (x < ntotal - 1 && y < ntotal);
-        eaf_adjust_memory(eaf[l], nobj);
+        callback (arg, l, NULL, NULL);
     }
     free(save_attained);
     free(attained);
     free(runtab);
     free(datay);
     free(datax);
+}
 
-    return eaf;
+static void
+eaf2d_store_callback (void *arg, int l, const objective_t *p,
+                      const int *attained)
+{
+    eaf_t **eaf = (eaf_t **) arg;
+    const int nobj = 2;
+    if (p == NULL) {
+        eaf_adjust_memory(eaf[l], nobj);
+        return;
+    }
+    eaf_store_point_2d (eaf[l], p[0], p[1], attained);
 }
 
+/*
+   eaf2d: compute attainment surfaces from points in objective space,
+          using dimension sweeping.
+
+   Input arguments: see eaf2d_stream().
+
+   Returns one eaf_t per level, including the attainment indicators of each
+   point.
+*/
+
+eaf_t **
+eaf2d (const objective_t *data, const int *cumsize, int nruns,
+       const int *attlevel, const int nlevels)
+{
+    const int nobj = 2;
+    const int ntotal = cumsize[nruns - 1]; /* total number of points in data */
+    eaf_t **eaf = malloc(nlevels * sizeof(eaf_t*));
+    for (int l = 0; l < nlevels; l++)
+        eaf[l] = eaf_create (nobj, nruns, ntotal);
+
+    eaf2d_stream (data, cumsize, nruns, attlevel, nlevels,
+                  eaf2d_store_callback, eaf);
+    return eaf;
+}
 
 #if DEBUG_POLYGONS > 0
 #define PRINT_POINT(X,Y,C) do { \
@@ -533,13 +610,15 @@ polygons_intersect(const objective_t *a, const objective_t *b, int nobj)
 _attr_maybe_unused static void
 polygon_print(const objective_t *p, int nobj)
 {
+    outbuf_t *out = outbuf_new(stderr);
     while (p[0] != objective_MIN) {
-        point_printf(stderr, p, nobj);
-        fprintf(stderr, "\n");
+        point_printf(out, p, nobj);
+        outbuf_putc(out, '\n');
         p += nobj;
     }
-    point_printf(stderr, p, nobj);
-    fprintf(stderr, "\n");
+    point_printf(out, p, nobj);
+    outbuf_putc(out, '\n');
+    outbuf_free(out);
 }
 
 _attr_maybe_unused static void
@@ -922,17 +1001,21 @@ void
 eaf_print_polygon (FILE *stream, eaf_t **eaf, int nobj, int nlevels)
 {
     eaf_polygon_t *p = eaf_compute_area (eaf, nobj, nlevels);
+    outbuf_t *out = outbuf_new (stream);
 
     for(size_t i = 0; i < vector_objective_size(&p->xy); i += 2) {
-        point2d_printf(stream, vector_objective_at(&p->xy, i),
+        point2d_printf(out, vector_objective_at(&p->xy, i),
                        vector_objective_at(&p->xy, i + 1));
-        fprintf(stream, "\n");
+        outbuf_putc (out, '\n');
     }
 
-    fprintf (stream, "# col =");
-    for (size_t k = 0; k < vector_int_size (&p->col); k++)
-        fprintf (stream, " %d", vector_int_at(&p->col, k));
-    fprintf (stream, "\n");
+    outbuf_puts (out, "# col =");
+    for (size_t k = 0; k < vector_int_size (&p->col); k++) {
+        outbuf_putc (out, ' ');
+        outbuf_int (out, vector_int_at(&p->col, k));
+    }
+    outbuf_putc (out, '\n');
+    outbuf_free (out);
 
     vector_objective_dtor (&p->xy);
     vector_int_dtor (&p->col);
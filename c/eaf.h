@@ -36,14 +36,16 @@
 # define objective_t double
 # define objective_MAX INFINITY
 # define objective_MIN -INFINITY
-# define fread_objective_t fread_double
+# define parse_objective_t parse_double_token
 # define read_objective_t_data read_double_data
+# define read_objective_t_data_parallel read_double_data_parallel
 #elif OBJECTIVE_TYPE == OBJECTIVE_TYPE_INT
 # define objective_t int
 # define objective_MAX INT_MAX
 # define objective_MIN INT_MIN
-# define fread_objective_t fread_int
+# define parse_objective_t parse_int_token
 # define read_objective_t_data read_int_data
+# define read_objective_t_data_parallel read_int_data_parallel
 #else
 #error "Unknown OBJECTIVE_TYPE= value"
 #endif
@@ -62,9 +64,14 @@ typedef struct {
 
 void
 eaf_print_attsurf (const eaf_t *, int nobj,
-                   FILE *coord_file, /* output file (coordinates)           */
-                   FILE *indic_file, /* output file (attainment indicators) */
-                   FILE *diff_file); /* output file (difference nruns/2)    */
+                   outbuf_t *coord_file, /* output (coordinates)           */
+                   outbuf_t *indic_file, /* output (attainment indicators) */
+                   outbuf_t *diff_file); /* output (difference nruns/2)    */
+
+void
+eaf_print_line (outbuf_t *coord_file, outbuf_t *indic_file, outbuf_t *diff_file,
+                const objective_t *x, int nobj,
+                const bit_array *attained, int nruns);
 
 eaf_t * eaf_create (int nobj, int nruns, int npoints);
 void eaf_delete (eaf_t * eaf);
@@ -80,6 +87,21 @@ static inline int eaf_totalpoints (eaf_t **eaf, int n)
     return totalpoints;
 }
 
+/* Called for each point of each attainment surface. ATTAINED[k] > 0 iff the
+   point is attained by run k. After the last point of level L, it is called
+   with POINT == NULL and ATTAINED == NULL.  */
+typedef void (*eaf_callback_t) (void *arg, int level, const objective_t *point,
+                                const int *attained);
+
+void
+eaf2d_stream (const objective_t *data, /* the objective vectors            */
+              const int *cumsize,      /* the cumulative sizes of the runs */
+              int nruns,               /* the number of runs               */
+              const int *attlevel,     /* the desired attainment levels    */
+              int nlevels,             /* the number of att levels         */
+              eaf_callback_t callback, /* called for each output point     */
+              void *arg);              /* passed to callback               */
+
 eaf_t **
 eaf2d (const objective_t *data,    /* the objective vectors            */
        const int *cumsize,         /* the cumulative sizes of the runs */
@@ -89,16 +111,21 @@ eaf2d (const objective_t *data,    /* the objective vectors            */
     );
 
 eaf_t **
-eaf3d (objective_t *data, const int *cumsize, int nruns,
-       const int *attlevel, const int nlevels);
+eaf3d (const objective_t *data, const int *cumsize, int nruns,
+       const int *attlevel, const int nlevels, int nthreads);
+
+eaf_t **
+eafnd (const objective_t *data, int nobj, const int *cumsize, int nruns,
+       const int *attlevel, const int nlevels, int nthreads);
 
 static inline eaf_t **
-attsurf (objective_t *data,          /* the objective vectors            */
+attsurf (const objective_t *data,    /* the objective vectors            */
          int nobj,                   /* the number of objectives         */
          const int *cumsize,         /* the cumulative sizes of the runs */
          int nruns,		     /* the number of runs               */
          const int *attlevel,        /* the desired attainment levels    */
-         int nlevels                 /* the number of att levels         */
+         int nlevels,                /* the number of att levels         */
+         int nthreads                /* the maximum number of threads    */
     )
 {
     switch (nobj) {
@@ -106,10 +133,12 @@ attsurf (objective_t *data,          /* the objective vectors            */
           return eaf2d (data, cumsize, nruns, attlevel, nlevels);
           break;
       case 3:
-          return eaf3d (data, cumsize, nruns, attlevel, nlevels);
+          return eaf3d (data, cumsize, nruns, attlevel, nlevels, nthreads);
           break;
       default:
-          fatal_error("this implementation only supports two or three dimensions.\n");
+          if (nobj > 3)
+              return eafnd (data, nobj, cumsize, nruns, attlevel, nlevels, nthreads);
+          fatal_error("this implementation only supports two or more dimensions.\n");
     }
 }
 
@@ -118,17 +147,9 @@ attained_left_right (const bit_array *attained, int division, int total,
                      int *count_left, int *count_right)
 {
     assert (division < total);
-    int count_l = 0;
-    int count_r = 0;
-    int k;
-
-    for (k = 0; k < division; k++)
-        if (bit_array_get(attained,  k)) count_l++;
-    for (k = division; k < total; k++)
-        if (bit_array_get(attained,  k)) count_r++;
-
-    *count_left = count_l;
-    *count_right = count_r;
+    *count_left = (int) bit_array_count_range(attained, 0, (size_t) division);
+    *count_right = (int) bit_array_count_range(attained, (size_t) division,
+                                               (size_t) total);
 }
 
 static inline double
@@ -184,7 +205,7 @@ void eaf2matrix(double *rmat, eaf_t * const * eaf, int nobj, _attr_maybe_unused
                 const double * percentile, int nlevels);
 
 double *
-eaf_compute_matrix(int *eaf_npoints, double * data, int nobj, const int *cumsizes, int nruns,
+eaf_compute_matrix(int *eaf_npoints, const double * data, int nobj, const int *cumsizes, int nruns,
                    const double * percentile, int nlevels);
 
 static inline double
@@ -198,11 +219,27 @@ eafdiff_percentile (const eaf_t * eaf, size_t i, int division, int nruns, int n_
 }
 
 double *
-eafdiff_compute_rectangles(int *eaf_npoints, double * data, int nobj,
+eafdiff_compute_rectangles(int *eaf_npoints, const double * data, int nobj,
                            const int *cumsizes, int nruns, int intervals);
 double *
-eafdiff_compute_matrix(int *eaf_npoints, double * data, int nobj,
+eafdiff_compute_matrix(int *eaf_npoints, const double * data, int nobj,
                        const int *cumsizes, int nruns, int intervals);
+void
+eafdiff_whv (double *whv, const double *points, int npoints,
+             const double *data, const int *cumsizes, int nruns,
+             int intervals, const double *ref);
+double
+largest_eafdiff (int *best, const double *data, const int *cumsizes,
+                 const int *nruns, int n, int intervals,
+                 const double *lower, const double *upper, int nthreads);
+
+double *
+vorob_t(int *ve_npoints, double *threshold, double *avg_hyp,
+        const double *data, int nobj, const int *cumsizes, int nruns,
+        const double *ref);
+double
+vorob_dev(const double *data, int nobj, const int *cumsizes, int nruns,
+          const double *ve, int ve_npoints, const double *ref);
 
 #define cvector_assert(X) assert(X)
 #include "cvector.h"
@@ -28,17 +28,32 @@
 
 #include "eaf.h"
 #include "avl.h"
+#include "pool.h"
 
 typedef struct dlnode {
-    objective_t *x;             /* The data vector */
+    const objective_t *x;       /* The data vector */
     struct dlnode *next;
     struct dlnode *prev;
     int set;
 } dlnode_t;
 
-typedef struct removed_list {
-    avl_node_t *head;
-} removed_list_t;
+/* All tree nodes and all points created by the sweep are taken from these
+   pools, which are released at once at the end.  Nodes removed from a level
+   are never recycled because other nodes may point to them as promoters or
+   removers.  */
+typedef struct eaf3d_pools {
+    pool_t nodes;
+    pool_t points;
+    int nnodes;
+} eaf3d_pools_t;
+
+static inline avl_node_t *
+new_node(eaf3d_pools_t *pools)
+{
+    avl_node_t *node = pool_alloc(&pools->nodes);
+    node->id = pools->nnodes++;
+    return node;
+}
 
 /*
 static bool avl_tree_is_empty (const avl_tree_t *avltree)
@@ -66,7 +81,7 @@ static int compare_node(const void *p1, const void *p2)
   Create a list of points, ordered by the third coordinate.
 */
 static dlnode_t *
-setup_cdllist(objective_t *data, int d, const int *cumsize, int nsets)
+setup_cdllist(const objective_t *data, int d, const int *cumsize, int nsets)
 {
     int n = cumsize[nsets - 1];
     dlnode_t *head = malloc ((n + 1) * sizeof(dlnode_t));
@@ -170,26 +185,40 @@ static int avl_search_closest_y(const avl_tree_t *avltree, const void *item, avl
 }
 
 
+/* The promoters and removers form a DAG, in which many paths lead to the same
+   node when there are ties.  If VISITED is not NULL, nodes with VISITED[id] ==
+   STAMP are not visited again, which avoids an exponential number of paths.  */
 static void
-find_all_promoters(avl_node_t * avlnode, int * dom_sets, int nruns)
+find_all_promoters_visit(avl_node_t * avlnode, int * dom_sets, int * visited,
+                         int stamp)
 {
-    avl_node_t *node = avlnode;
+    avl_node_t *node = avlnode->equal;
 
     while (node != NULL) {
         dom_sets[node->set] = 1;
-        if (node->remover != NULL)
-            find_all_promoters(node->remover, dom_sets, nruns);
-        node = node->promoter;
+        node = node->equal;
     }
 
-    node = avlnode->equal;
-
+    node = avlnode;
     while (node != NULL) {
+        if (visited) {
+            if (visited[node->id] == stamp)
+                break;
+            visited[node->id] = stamp;
+        }
         dom_sets[node->set] = 1;
-        node = node->equal;
+        if (node->remover != NULL)
+            find_all_promoters_visit(node->remover, dom_sets, visited, stamp);
+        node = node->promoter;
     }
 }
 
+static void
+find_all_promoters(avl_node_t * avlnode, int * dom_sets, _attr_maybe_unused int nruns)
+{
+    find_all_promoters_visit(avlnode, dom_sets, NULL, 0);
+}
+
 /*
   Prints the list in the tree, ordered by the second dimension, from the highest value to the lowest.
   The values printed are the values from dimension 0 to dimension dim of each point
@@ -197,16 +226,19 @@ find_all_promoters(avl_node_t * avlnode, int * dom_sets, int nruns)
 static void
 printlist(const avl_tree_t *avltree, int dim, FILE *outfile)
 {
+    outbuf_t *out = outbuf_new(outfile);
     avl_node_t *aux = avltree->head;
     while(aux){
         objective_t * val = (objective_t *)aux->item;
         //printf("-> ");
         for (int i = 0; i < dim; i++){
-            fprintf(outfile, point_printf_format "\t", val[i]);
+            outbuf_point(out, val[i]);
+            outbuf_putc(out, '\t');
         }
-        fprintf(outfile, "\n");
+        outbuf_putc(out, '\n');
         aux = aux->next;
     }
+    outbuf_free(out);
 }
 
 
@@ -234,7 +266,7 @@ void printlevel(FILE * stream, avl_tree_t **level, int nset)
 
 
 static int
-printlist_points_indic(avl_tree_t *avltree, int dim, int nruns, FILE *outfile, FILE *outfileindic)
+printlist_points_indic(avl_tree_t *avltree, int dim, int nruns, outbuf_t *outfile, outbuf_t *outfileindic)
 {
     int * dom_sets = (int *) malloc(nruns * sizeof(int));
     int i, k, totalp = 0;
@@ -242,21 +274,23 @@ printlist_points_indic(avl_tree_t *avltree, int dim, int nruns, FILE *outfile, F
     while (aux) {
             objective_t * val  = (objective_t *)aux->item;
         if (outfile) {
-            fprintf(outfile, point_printf_format, val[0]);
+            outbuf_point(outfile, val[0]);
             for (i = 1; i < dim; i++){
-                fprintf(outfile, "\t" point_printf_format, val[i]);
+                outbuf_putc(outfile, '\t');
+                outbuf_point(outfile, val[i]);
             }
-            fprintf(outfile, (outfile == outfileindic) ? "\t" : "\n");
+            outbuf_putc(outfile, (outfile == outfileindic) ? '\t' : '\n');
         }
         if (outfileindic) {
             for (k = 0; k < nruns; k++)
                 dom_sets[k] = 0;
             find_all_promoters(aux, dom_sets, nruns);
-            fprintf(outfileindic, "%d", dom_sets[0]);
+            outbuf_int(outfileindic, dom_sets[0]);
             for (k = 1; k < nruns; k++){
-                fprintf(outfileindic, "\t%d", dom_sets[k]);
+                outbuf_putc(outfileindic, '\t');
+                outbuf_int(outfileindic, dom_sets[k]);
             }
-            fprintf(outfileindic, "\n");
+            outbuf_putc(outfileindic, '\n');
         }
         aux = aux->next;
 
@@ -275,18 +309,24 @@ int printoutput(avl_tree_t **level, int nset, int d, FILE **outfile, int noutfil
         int k = attlevel[i] - 1;
         int f = (noutfiles > 1) ? i : 0;
         int fi = (noutfilesi > 1) ? i : 0;
+        outbuf_t *out = outfile ? outbuf_new(outfile[f]) : NULL;
+        outbuf_t *outindic = (outfileindic == NULL) ? NULL
+            : (outfile && outfile[f] == outfileindic[fi]) ? out : outbuf_new(outfileindic[fi]);
 
         if (level[k]->head != NULL) {
-            totalp += printlist_points_indic(level[k], d, nset, (outfile ? outfile[f] : NULL), (outfileindic ? outfileindic[fi] : NULL));
+            totalp += printlist_points_indic(level[k], d, nset, out, outindic);
         }
 
         if (i < nlevels - 1) {
-            if (outfile)
-                fprintf(outfile[f], "\n");
-            if (outfileindic && (outfile == NULL || outfile[f] != outfileindic[fi])){
-                fprintf(outfileindic[fi], "\n");
+            if (out)
+                outbuf_putc(out, '\n');
+            if (outindic && outindic != out){
+                outbuf_putc(outindic, '\n');
             }
         }
+        if (outindic != out)
+            outbuf_free(outindic);
+        outbuf_free(out);
     }
     return totalp;
 }
@@ -339,17 +379,18 @@ void add2output(avl_tree_t *output, avl_node_t *tnode)
     }
 }
 
-void add2output_all(avl_tree_t *output, avl_tree_t *tree_add){
-
+static void
+add2output_all(eaf3d_pools_t *pools, avl_tree_t *output, avl_tree_t *tree_add)
+{
     avl_node_t *node = tree_add->head;
     avl_unlink_node(tree_add, node);
-    free(node->item);
-    free(node);
+    pool_free(&pools->points, node->item);
+    pool_free(&pools->nodes, node);
 
     node = tree_add->tail;
     avl_unlink_node(tree_add, node);
-    free(node->item);
-    free(node);
+    pool_free(&pools->points, node->item);
+    pool_free(&pools->nodes, node);
 
 
     if(tree_add->head != NULL){
@@ -366,9 +407,10 @@ void add2output_all(avl_tree_t *output, avl_tree_t *tree_add){
 //this fuction is called only when item isn't dominated by any point in tree.
 //note: prevnode is above and at item's left, so any dominated point that it may dominate is at its right
 static void
-add2set(avl_tree_t *tree, avl_node_t *prevnode, avl_node_t *tnode, objective_t *item)
+add2set(eaf3d_pools_t *pools, avl_tree_t *tree, avl_node_t *prevnode,
+        avl_node_t *tnode, const objective_t *item)
 {
-    avl_init_node (tnode, item);
+    avl_init_node (tnode, (void *) item);
     if (node_point(prevnode)[0] == item[0])
         prevnode = prevnode->prev;
     avl_insert_after (tree, prevnode, tnode);
@@ -380,7 +422,7 @@ add2set(avl_tree_t *tree, avl_node_t *prevnode, avl_node_t *tnode, objective_t *
         avl_unlink_node(tree, tnode);
         avl_node_t *node = tnode;
         tnode = tnode->next;
-        free(node);
+        pool_free(&pools->nodes, node);
     }
 
 }
@@ -395,14 +437,8 @@ static void avl_add_promoter(avl_node_t *avlnode, int set, avl_node_t *promoter)
 }
 
 
-static void add_removed(removed_list_t * removed_list, avl_node_t *node)
-{
-    node->next = removed_list->head;
-    removed_list->head = node;
-}
-
 static avl_node_t *
-add2level(removed_list_t * removed_list, avl_tree_t *tree,
+add2level(eaf3d_pools_t *pools, avl_tree_t *tree,
           objective_t *item, avl_tree_t *output, int set, avl_node_t * promoter)
 {
     avl_node_t *prevnode;
@@ -422,7 +458,7 @@ add2level(removed_list_t * removed_list, avl_tree_t *tree,
     avl_node_t *aux = prevnode->next;
     // A new point (item) is added, but only if it isn't dominated.
     if (node_point(aux)[0] > item[0]) {
-        avl_node_t *tnode = malloc(sizeof(avl_node_t));
+        avl_node_t *tnode = new_node(pools);
         avl_init_node(tnode, item);
         avl_add_promoter(tnode, set, promoter);
         avl_node_t *newnode = tnode;
@@ -437,8 +473,8 @@ add2level(removed_list_t * removed_list, avl_tree_t *tree,
             if (node_point(aux)[2] < item[2])
                 add2output(output, aux);
             else{
-                free(aux->item);
-                add_removed(removed_list, aux);
+                pool_free(&pools->points, aux->item);
+                aux->item = NULL;
                 aux->remover = newnode;
             }
             /* Each point that is removed from this level,
@@ -448,15 +484,15 @@ add2level(removed_list_t * removed_list, avl_tree_t *tree,
         }
         return newnode;
     } else{
-        free(item);
+        pool_free(&pools->points, item);
         return NULL;
     }
 }
 
 
-static objective_t * copy_point(const objective_t * v)
+static objective_t * copy_point(eaf3d_pools_t *pools, const objective_t * v)
 {
-    objective_t *value = malloc(3 * sizeof(objective_t));
+    objective_t *value = pool_alloc(&pools->points);
 
     value[0] = v[0];
     value[1] = v[1];
@@ -466,7 +502,7 @@ static objective_t * copy_point(const objective_t * v)
 }
 
 //at left or equal
-static avl_node_t * find_point_at_left(avl_tree_t *tree, objective_t *item){
+static avl_node_t * find_point_at_left(avl_tree_t *tree, const objective_t *item){
 
     avl_node_t *leftNode;
 
@@ -489,9 +525,10 @@ static avl_node_t * find_point_below(avl_tree_t *tree, objective_t *item)
 
 
 
-static objective_t * new_point(objective_t x1, objective_t x2, objective_t x3)
+static objective_t *
+new_point(eaf3d_pools_t *pools, objective_t x1, objective_t x2, objective_t x3)
 {
-    objective_t *value = malloc(3 * sizeof(objective_t));
+    objective_t *value = pool_alloc(&pools->points);
     value[0] = x1;
     value[1] = x2;
     value[2] = x3;
@@ -499,9 +536,10 @@ static objective_t * new_point(objective_t x1, objective_t x2, objective_t x3)
 }
 
 
-void
-eaf3df(removed_list_t * removed_list, dlnode_t *list, avl_tree_t **set,
-       avl_tree_t **level, avl_tree_t **output, int nset)
+/* Levels above MAXLEVEL are not needed, so points are not promoted to them.  */
+static void
+eaf3df(eaf3d_pools_t *pools, dlnode_t *list, avl_tree_t **set,
+       avl_tree_t **level, avl_tree_t **output, int nset, int maxlevel)
 {
     struct aux_nodes {
         /* levelNode[t] is the point being verified (possibly to be promoted) from level t,
@@ -519,11 +557,11 @@ eaf3df(removed_list_t * removed_list, dlnode_t *list, avl_tree_t **set,
     dlnode_t *new = list->next; //new - represents the new point
 
     //add new to its set
-    avl_node_t * tnode = avl_init_node(malloc(sizeof(avl_node_t)), new->x);
+    avl_node_t * tnode = avl_init_node(new_node(pools), (void *) new->x);
     avl_insert_after(set[new->set], set[new->set]->head, tnode);
 
     //new is the only point so far, so it is added to the first level
-    tnode = avl_init_node(malloc(sizeof(avl_node_t)), copy_point(new->x));
+    tnode = avl_init_node(new_node(pools), copy_point(pools, new->x));
     avl_add_promoter(tnode, new->set, NULL);
     avl_insert_after(level[0], level[0]->head, tnode);
 
@@ -596,8 +634,8 @@ eaf3df(removed_list_t * removed_list, dlnode_t *list, avl_tree_t **set,
                         aux[k].levelNode = find_point_below(level[k], setNode->item);
                         aux[k].promoter = aux[k].levelNode;
                     } else {
-                        objective_t *value = new_point(node_point(aux[k].levelNode)[0], node_point(aux[k].levelNode)[1], new->x[2]);
-                        tnode = add2level(removed_list, level[k+1], value, output[k+1], new->set, aux[k].promoter);
+                        objective_t *value = new_point(pools, node_point(aux[k].levelNode)[0], node_point(aux[k].levelNode)[1], new->x[2]);
+                        tnode = add2level(pools, level[k+1], value, output[k+1], new->set, aux[k].promoter);
                         if(tnode != NULL && new->x[2] == node_point(aux[k].promoter)[2] && node_point(aux[k].levelNode)[0] == node_point(aux[k].promoter)[0]){
                             aux[k].promoter->equal = tnode;
                         }
@@ -616,8 +654,8 @@ eaf3df(removed_list_t * removed_list, dlnode_t *list, avl_tree_t **set,
             //isn't dominated, it is added to level k+1
             if(node_point(aux[k].levelNode)[0] < node_point(setNode)[0]){
 
-                objective_t *value =new_point(node_point(aux[k].levelNode)[0], new->x[1], new->x[2]);
-                tnode = add2level(removed_list, level[k+1], value, output[k+1], new->set, aux[k].promoter);
+                objective_t *value = new_point(pools, node_point(aux[k].levelNode)[0], new->x[1], new->x[2]);
+                tnode = add2level(pools, level[k+1], value, output[k+1], new->set, aux[k].promoter);
                 if (tnode != NULL && new->x[2] == node_point(aux[k].levelNode)[2] && new->x[1] == node_point(aux[k].levelNode)[1]){
                     aux[k].promoter->equal = tnode;
                 }
@@ -625,18 +663,18 @@ eaf3df(removed_list_t * removed_list, dlnode_t *list, avl_tree_t **set,
         }
 
         //add new to its set
-        tnode = avl_init_node(malloc(sizeof(avl_node_t)), new->x);
-        add2set(set[new->set], newPrev, tnode, new->x);
+        tnode = avl_init_node(new_node(pools), (void *) new->x);
+        add2set(pools, set[new->set], newPrev, tnode, new->x);
 
         //add new to the lowest level where it isn't dominated by any point from that level
-        tnode = add2level(removed_list, level[stop_at], copy_point(new->x), output[stop_at], new->set, dom_new);
+        tnode = add2level(pools, level[stop_at], copy_point(pools, new->x), output[stop_at], new->set, dom_new);
         if(stop_at > 0 && tnode != NULL && new->x[2] == node_point(dom_new)[2] &&
            new->x[1] == node_point(dom_new)[1] && new->x[0] == node_point(dom_new)[0]){
             dom_new->equal = tnode;
         }
 
         if (!mask[new->set]) {
-            if (start_at < (nset - 2))
+            if (start_at < (MIN(nset, maxlevel) - 2))
                 start_at++;
             mask[new->set] = true;
         }
@@ -647,82 +685,14 @@ eaf3df(removed_list_t * removed_list, dlnode_t *list, avl_tree_t **set,
 
 
 static void
-freetree(avl_tree_t *avltree)
-{
-    avl_node_t *aux, *aux2;
-    aux=avltree->head;
-
-    if(aux){ // FIXME: Double check of aux?
-        while(aux){
-            aux2 = aux;
-            aux = aux2->next;
-            free(aux2->item);
-            free(aux2);
-        }
-    }
-
-    free(avltree);
-}
-
-static void
-freetree2(avl_tree_t *avltree)
-{
-    avl_node_t *aux, *aux2;
-    aux=avltree->head;
-
-    free(aux->item);
-
-    while(aux->next){
-        aux2 = aux;
-        aux = aux2->next;
-        // FIXME: aux2->time is not freed?
-        free(aux2);
-    }
-    // FIXME: Double free of aux->item
-    free(aux->item);
-    free(aux);
-
-    free(avltree);
-}
-
-
-static void free_removed(removed_list_t * removed_list)
-{
-    avl_node_t * node = removed_list->head;
-    while (node != NULL) {
-        avl_node_t * aux = node;
-        node = node->next;
-        // FIXME: Do not free aux->item? Same as freetree()?
-        free(aux);
-    }
-    free(removed_list);
-}
-
-_attr_maybe_unused static void
-freeoutput(removed_list_t * removed_list, avl_tree_t **output, int nset)
+add_sentinels(eaf3d_pools_t *pools, avl_tree_t * tree)
 {
-    for (int i = 0; i < nset; i++){
-        freetree(output[i]);
-    }
-    free(output);
-    free_removed(removed_list);
-}
-
-
-void add_sentinels(avl_tree_t * tree, int n)
-{
-    objective_t *value = malloc(n * sizeof(objective_t));
-    value[0] = objective_MIN;
-    value[1] = objective_MAX;
-
-    avl_node_t *tnode = avl_init_node(malloc(sizeof(avl_node_t)), value);
+    objective_t *value = new_point(pools, objective_MIN, objective_MAX, 0);
+    avl_node_t *tnode = avl_init_node(new_node(pools), value);
     avl_insert_top(tree, tnode);
 
-    value = malloc(n * sizeof(objective_t));
-    value[0] = objective_MAX;
-    value[1] = objective_MIN;
-
-    avl_node_t *tnode2 = avl_init_node(malloc(sizeof(avl_node_t)), value);
+    value = new_point(pools, objective_MAX, objective_MIN, 0);
+    avl_node_t *tnode2 = avl_init_node(new_node(pools), value);
     avl_insert_after(tree, tnode, tnode2);
 }
 
@@ -740,8 +710,8 @@ eaf_store_point_3d (eaf_t * eaf, objective_t x, objective_t y, objective_t z,
 
 
 eaf_t **
-eaf3d (objective_t *data, const int *cumsize, int nruns,
-       const int *attlevel, const int nlevels)
+eaf3d (const objective_t *data, const int *cumsize, int nruns,
+       const int *attlevel, const int nlevels, int nthreads)
 {
     const int nobj = 3;
     const int ntotal = cumsize[nruns - 1]; /* total number of points in data */
@@ -750,65 +720,75 @@ eaf3d (objective_t *data, const int *cumsize, int nruns,
             assert(cumsize[i-1] < cumsize[i]);
         );
 
-    /* FIXME: This seems wrong. It should be:
-       avl_tree_t * set = malloc (nruns * sizeof(*set));
-       avl_tree_t * level = malloc (nruns * sizeof(*level));
-       avl_tree_t * output = malloc (nruns * sizeof(*output));
+    avl_tree_t *trees = malloc (3 * nruns * sizeof(avl_tree_t));
+    avl_tree_t **set = malloc (3 * nruns * sizeof(avl_tree_t *));
+    avl_tree_t **level = set + nruns;
+    avl_tree_t **output = set + 2 * nruns;
 
-       This way we do not need to do avl_alloc_tree for each tree, which
-       creates a lot of small memory chunks.
-    */
-    avl_tree_t **set = malloc (nruns * sizeof(avl_tree_t));
-    avl_tree_t **level = malloc (nruns * sizeof(avl_tree_t));
-    avl_tree_t **output = malloc (nruns * sizeof(avl_tree_t));
+    eaf3d_pools_t pools;
+    pool_ctor(&pools.nodes, sizeof(avl_node_t), (size_t) ntotal);
+    pool_ctor(&pools.points, nobj * sizeof(objective_t), (size_t) ntotal);
+    pools.nnodes = 0;
 
     int i;
     for (i = 0; i < nruns; i++) {
-        set[i]  = avl_alloc_tree ((avl_compare_t) compare_tree_asc_x, (avl_freeitem_t) free);
-        level[i]  = avl_alloc_tree ((avl_compare_t) compare_tree_asc_x, (avl_freeitem_t) free);
-        output[i]  = avl_alloc_tree ((avl_compare_t) compare_tree_asc_x, (avl_freeitem_t) free);
-
-        add_sentinels(set[i], nobj);
-        add_sentinels(level[i], nobj);
-
+        set[i] = avl_init_tree (trees + i, (avl_compare_t) compare_tree_asc_x, NULL);
+        level[i] = avl_init_tree (trees + nruns + i, (avl_compare_t) compare_tree_asc_x, NULL);
+        output[i] = avl_init_tree (trees + 2 * nruns + i, (avl_compare_t) compare_tree_asc_x, NULL);
+        add_sentinels(&pools, set[i]);
+        add_sentinels(&pools, level[i]);
     }
 
-    removed_list_t * removed_list = (removed_list_t *) malloc(sizeof(removed_list_t));
-    removed_list->head = NULL;
-    dlnode_t *list = setup_cdllist(data, nobj, cumsize, nruns);
-    eaf3df(removed_list, list, set, level, output, nruns);
+    int maxlevel = 0;
+    for (i = 0; i < nlevels; i++)
+        maxlevel = MAX(maxlevel, attlevel[i]);
 
-    for (i = 0; i < nruns; i++) {
-        add2output_all(output[i], level[i]);
-    }
+    dlnode_t *list = setup_cdllist(data, nobj, cumsize, nruns);
+    eaf3df(&pools, list, set, level, output, nruns, maxlevel);
+    free(list);
 
     for (i = 0; i < nruns; i++) {
-        freetree2(set[i]);
-        free(level[i]);
+        add2output_all(&pools, output[i], level[i]);
     }
 
-    free(list);
-    free(set);
-    free(level);
-
     /* Create output EAF */
     /* FIXME: This should be done earlier instead of creating the trees. */
 
+    /* Recovering the attainment indicators of each point dominates the
+       running time, but each level only reads the (now fixed) output trees,
+       so levels are processed in parallel.  */
     eaf_t **eaf = malloc(nlevels * sizeof(eaf_t*));
-    int * attained = malloc(nruns * sizeof(int));
-    for (int l = 0; l < nlevels; l++) {
-        eaf[l] = eaf_create (nobj, nruns, ntotal);
-        int k = attlevel[l] - 1;
-        avl_node_t * aux = output[k]->head;
-        while (aux) {
-            objective_t * val = aux->item;
-            for(int j = 0; j < nruns; j++)
-                attained[j] = 0;
-            find_all_promoters(aux, attained, nruns);
-            eaf_store_point_3d (eaf[l], val[0], val[1], val[2],
-                                attained);
-            aux = aux->next;
+    if (nthreads < 1) nthreads = 1;
+#ifdef _OPENMP
+#pragma omp parallel num_threads(nthreads) if (nthreads > 1 && nlevels > 1)
+#endif
+    {
+        int * attained = malloc(nruns * sizeof(int));
+        int * visited = calloc(pools.nnodes, sizeof(int));
+        int stamp = 0;
+#ifdef _OPENMP
+#pragma omp for schedule(dynamic, 1)
+#endif
+        for (int l = 0; l < nlevels; l++) {
+            eaf[l] = eaf_create (nobj, nruns, ntotal);
+            int k = attlevel[l] - 1;
+            avl_node_t * aux = output[k]->head;
+            while (aux) {
+                objective_t * val = aux->item;
+                for(int j = 0; j < nruns; j++)
+                    attained[j] = 0;
+                find_all_promoters_visit(aux, attained, visited, ++stamp);
+                eaf_store_point_3d (eaf[l], val[0], val[1], val[2],
+                                    attained);
+                aux = aux->next;
+            }
         }
+        free(visited);
+        free(attained);
     }
+    pool_dtor(&pools.points);
+    pool_dtor(&pools.nodes);
+    free(set);
+    free(trees);
     return eaf;
 }
@@ -56,6 +56,8 @@ OPTION_VERSION_STR
 " -w, --worst         compute worst attainment surface                      \n"
 " -p, --percentile REAL compute the given percentile of the EAF             \n"
 " -l, --level  LEVEL    compute the given level of the EAF                  \n"
+" -j, --jobs N        use up to N threads to read the input and to compute  \n"
+"                     3+ objectives. Default is 1.                          \n"
 " -i[FILE], --indices[=FILE]  write attainment indices to FILE.             \n"
 "                     If FILE is '-', print to stdout.                      \n"
 "                     If FILE is missing use the same file as for output.   \n"
@@ -135,25 +137,99 @@ static int read_ints (int *levels, char *str)
     return k - 1;
 }
 
+struct eaf_print_stream {
+    outbuf_t *coord_file;
+    outbuf_t *indic_file;
+    outbuf_t *diff_file;
+    bit_array *attained;
+    int nruns;
+};
+
+/* Create one buffered output for each distinct stream.  */
+static void
+eaf_print_stream_open (struct eaf_print_stream *s, FILE *coord_file,
+                       FILE *indic_file, FILE *diff_file)
+{
+    s->coord_file = coord_file ? outbuf_new (coord_file) : NULL;
+    s->indic_file = (indic_file == NULL) ? NULL
+        : (indic_file == coord_file) ? s->coord_file : outbuf_new (indic_file);
+    s->diff_file = (diff_file == NULL) ? NULL
+        : (diff_file == coord_file) ? s->coord_file
+        : (diff_file == indic_file) ? s->indic_file : outbuf_new (diff_file);
+}
+
+static void
+eaf_print_stream_close (struct eaf_print_stream *s)
+{
+    if (s->diff_file != s->coord_file && s->diff_file != s->indic_file)
+        outbuf_free (s->diff_file);
+    if (s->indic_file != s->coord_file)
+        outbuf_free (s->indic_file);
+    outbuf_free (s->coord_file);
+}
+
+static void
+eaf_print_level_end (const struct eaf_print_stream *s)
+{
+    if (s->coord_file)
+        outbuf_putc (s->coord_file, '\n');
+    else if (s->indic_file)
+        outbuf_putc (s->indic_file, '\n');
+    else if (s->diff_file)
+        outbuf_putc (s->diff_file, '\n');
+}
+
 static void
 eaf_print (eaf_t **eaf, int nobj, int nlevels,
            FILE *coord_file, FILE *indic_file, FILE *diff_file)
 {
+    struct eaf_print_stream s;
+    eaf_print_stream_open (&s, coord_file, indic_file, diff_file);
     for (int k = 0; k < nlevels; k++) {
-        eaf_print_attsurf (eaf[k], nobj, coord_file, indic_file, diff_file);
-        if (coord_file)
-            fprintf (coord_file, "\n");
-        else if (indic_file)
-            fprintf(indic_file, "\n");
-        else if (diff_file)
-            fprintf(diff_file, "\n");
+        eaf_print_attsurf (eaf[k], nobj, s.coord_file, s.indic_file, s.diff_file);
+        eaf_print_level_end (&s);
     }
+    eaf_print_stream_close (&s);
+}
+
+static void
+eaf_print_callback (void *arg, _attr_maybe_unused int level,
+                    const objective_t *point, const int *attained)
+{
+    struct eaf_print_stream *s = (struct eaf_print_stream *) arg;
+    if (point == NULL) {
+        eaf_print_level_end (s);
+        return;
+    }
+    /* Indicators are only converted if they will be printed.  */
+    if (s->attained)
+        bit_array_set_from_int(s->attained, attained, s->nruns);
+    eaf_print_line (s->coord_file, s->indic_file, s->diff_file,
+                    point, 2, s->attained, s->nruns);
+}
+
+/* In 2D, print each point as soon as it is computed instead of storing all
+   levels in memory.  */
+static void
+eaf2d_print (const objective_t *data, const int *cumsizes, int nruns,
+             const int *level, int nlevels,
+             FILE *coord_file, FILE *indic_file, FILE *diff_file)
+{
+    struct eaf_print_stream s = { .attained = NULL, .nruns = nruns };
+    eaf_print_stream_open (&s, coord_file, indic_file, diff_file);
+    if (indic_file || diff_file)
+        s.attained = bit_array_alloc(nruns);
+    eaf2d_stream (data, cumsizes, nruns, level, nlevels,
+                  eaf_print_callback, &s);
+    free (s.attained);
+    eaf_print_stream_close (&s);
 }
 
 void read_input_data (const char *filename, objective_t **data_p,
-                      int *nobjs_p, int **cumsizes_p, int *nsets_p)
+                      int *nobjs_p, int **cumsizes_p, int *nsets_p, int nthreads)
 {
-    int error = read_objective_t_data (filename, data_p, nobjs_p, cumsizes_p, nsets_p);
+    int error = read_objective_t_data_parallel (filename, data_p, nobjs_p, cumsizes_p,
+                                                nsets_p, nthreads);
     switch (error) {
       case 0: /* No error */
           break;
@@ -186,7 +262,7 @@ int main(int argc, char *argv[])
     int option;
     int longopt_index;
     /* see the man page for getopt_long for an explanation of these fields */
-    static const char short_options[] = "hVvqbmwl:p:o:i::d::P";
+    static const char short_options[] = "hVvqbmwl:p:o:i::d::Pj:";
     static const struct option long_options[] = {
         {"help",       no_argument,       NULL, 'h'},
         {"version",    no_argument,       NULL, 'V'},
@@ -204,6 +280,7 @@ int main(int argc, char *argv[])
         {"percentile", required_argument, NULL, 'p'},
         {"level",      required_argument, NULL, 'l'},
         {"polygons",   no_argument,       NULL, 'P'},
+        {"jobs",       required_argument, NULL, 'j'},
         {NULL, 0, NULL, 0} /* marks end of list */
     };
 #define MAX_LEVELS 50
@@ -211,6 +288,7 @@ int main(int argc, char *argv[])
     int nlevels = 0;
     double *percentile = malloc(MAX_LEVELS * sizeof(double));
     int npercentiles = 0;
+    int nthreads = 1;
 
     set_program_invocation_short_name(argv[0]);
 
@@ -279,6 +357,10 @@ int main(int argc, char *argv[])
             polygon_flag = true;
             break;
 
+        case 'j': // --jobs
+            nthreads = parse_cmdline_jobs(optarg);
+            break;
+
         case 'q': // --quiet
             verbose_flag = false;
             break;
@@ -299,12 +381,12 @@ int main(int argc, char *argv[])
         for (k = optind; k < argc; k++) {
             if (strcmp (argv[k],"-"))
                 read_input_data (argv[k], &data, &nobj,
-                                 &cumsizes, &nruns);
+                                 &cumsizes, &nruns, nthreads);
             else
-                read_input_data (NULL, &data, &nobj, &cumsizes, &nruns);
+                read_input_data (NULL, &data, &nobj, &cumsizes, &nruns, nthreads);
         }
     } else
-        read_input_data (NULL, &data, &nobj, &cumsizes, &nruns);
+        read_input_data (NULL, &data, &nobj, &cumsizes, &nruns, nthreads);
 
 
     if (coord_filename) {
@@ -405,7 +487,22 @@ int main(int argc, char *argv[])
         fprintf (stderr, "\n");
     }
 
-    eaf_t **eaf = attsurf (data, nobj, cumsizes, nruns, level, nlevels);
+    if (nobj == 2 && !polygon_flag) {
+        eaf2d_print (data, cumsizes, nruns, level, nlevels,
+                     coord_file, indic_file, diff_file);
+        fclose (coord_file);
+        if (indic_file && indic_file != coord_file)
+            fclose (indic_file);
+        if (diff_file && diff_file != coord_file && diff_file != indic_file)
+            fclose (diff_file);
+        free(level);
+        free(percentile);
+        free(data);
+        free(cumsizes);
+        return 0;
+    }
+
+    eaf_t **eaf = attsurf (data, nobj, cumsizes, nruns, level, nlevels, nthreads);
 
     if (polygon_flag) {
         eaf_print_polygon (coord_file, eaf, nobj, nlevels);
@@ -421,6 +518,7 @@ int main(int argc, char *argv[])
     }
 
     free(level);
+    free(percentile);
     free(data);
     free(cumsizes);
     eaf_free(eaf, nlevels);
@@ -1,14 +1,14 @@
+#include <string.h>
 #include "eaf.h"
 
 /* FIXME: Rmoocore.R contains another version of this function. */
-/* FIXME: data cannot be const because eaf_compute_rectangles will sort it. */
 double *
-eafdiff_compute_rectangles(int *eaf_npoints, double * data, int nobj,
+eafdiff_compute_rectangles(int *eaf_npoints, const double * data, int nobj,
                            const int *cumsizes, int nruns, int intervals)
 {
     /* This returns all levels. attsurf() should probably handle this case. */
     int * level = levels_from_percentiles(NULL, nruns, nruns);
-    eaf_t **eaf = attsurf(data, nobj, cumsizes, nruns, level, nruns);
+    eaf_t **eaf = attsurf(data, nobj, cumsizes, nruns, level, nruns, 1);
     free (level);
 
     eaf_polygon_t * rects = eaf_compute_rectangles(eaf, nobj, nruns);
@@ -35,8 +35,33 @@ eafdiff_compute_rectangles(int *eaf_npoints, double * data, int nobj,
     return result;
 }
 
+struct eafdiff_matrix_stream {
+    vector_objective mat;
+    int division, nruns, intervals;
+};
+
+/* Same as eafdiff_percentile() but from the attainment indicators of the
+   current point.  */
+static void
+eafdiff_matrix_callback (void *arg, _attr_maybe_unused int l,
+                         const objective_t *p, const int *attained)
+{
+    struct eafdiff_matrix_stream * s = (struct eafdiff_matrix_stream *) arg;
+    if (p == NULL) return;
+    int count_left = 0, count_right = 0;
+    for (int k = 0; k < s->division; k++)
+        count_left += (attained[k] > 0);
+    for (int k = s->division; k < s->nruns; k++)
+        count_right += (attained[k] > 0);
+    vector_objective_push_back(&s->mat, p[0]);
+    vector_objective_push_back(&s->mat, p[1]);
+    vector_objective_push_back(&s->mat, s->intervals * (double) (
+                                   (count_left / (double) s->division)
+                                   - (count_right / (double) (s->nruns - s->division))));
+}
+
 double *
-eafdiff_compute_matrix(int *eaf_npoints, double * data, int nobj,
+eafdiff_compute_matrix(int *eaf_npoints, const double * data, int nobj,
                        const int *cumsizes, int nruns, int intervals)
 {
     // FIXME: This assumes that half of the runs come from each side of the
@@ -44,7 +69,19 @@ eafdiff_compute_matrix(int *eaf_npoints, double * data, int nobj,
     const int nsets1 = nruns / 2;
     /* This returns all levels. attsurf() should probably handle this case. */
     int * level = levels_from_percentiles(NULL, nruns, nruns);
-    eaf_t **eaf = attsurf(data, nobj, cumsizes, nruns, level, nruns);
+    if (nobj == 2) {
+        /* Only the current point of each level is needed, so stream the
+           points directly into the result matrix.  */
+        struct eafdiff_matrix_stream s = { .division = nsets1, .nruns = nruns,
+                                           .intervals = intervals };
+        vector_objective_ctor (&s.mat, 3 * (size_t) (256 + cumsizes[nruns - 1]));
+        eaf2d_stream (data, cumsizes, nruns, level, nruns,
+                      eafdiff_matrix_callback, &s);
+        free (level);
+        *eaf_npoints = (int) (vector_objective_size(&s.mat) / 3);
+        return vector_objective_begin(&s.mat);
+    }
+    eaf_t **eaf = attsurf(data, nobj, cumsizes, nruns, level, nruns, 1);
     free (level);
 
     const int nrow = eaf_totalpoints (eaf, nruns);
@@ -66,3 +103,279 @@ eafdiff_compute_matrix(int *eaf_npoints, double * data, int nobj,
     *eaf_npoints = nrow;
     return result;
 }
+
+/* Attainment surfaces of one set of runs (2D), stored as the points of all
+   levels sorted by the first objective.  Sweeping these points from left to
+   right gives, for each level, the lowest value of the second objective
+   attained so far.  */
+typedef struct {
+    objective_t x, y;
+    int level;
+} eafdiff_event_t;
+
+vector_define(vector_eafdiff_event, eafdiff_event_t)
+
+typedef struct {
+    vector_eafdiff_event ev;
+    int nruns;
+} eafdiff_levels_t;
+
+static void
+eafdiff_levels_callback (void *arg, int l, const objective_t *p,
+                         _attr_maybe_unused const int *attained)
+{
+    vector_eafdiff_event *ev = (vector_eafdiff_event *) arg;
+    if (p == NULL) return;
+    eafdiff_event_t e = { .x = p[0], .y = p[1], .level = l };
+    vector_eafdiff_event_push_back(ev, e);
+}
+
+static int
+cmp_event_x_asc (const void *p1, const void *p2)
+{
+    const objective_t x1 = ((const eafdiff_event_t *) p1)->x;
+    const objective_t x2 = ((const eafdiff_event_t *) p2)->x;
+    return (x1 < x2) ? -1 : ((x1 > x2) ? 1 : 0);
+}
+
+static void
+eafdiff_levels_ctor (eafdiff_levels_t *s, const double *data,
+                     const int *cumsizes, int nruns)
+{
+    int *level = levels_from_percentiles(NULL, nruns, nruns);
+    vector_eafdiff_event_ctor (&s->ev, (size_t) cumsizes[nruns - 1]);
+    eaf2d_stream (data, cumsizes, nruns, level, nruns,
+                  eafdiff_levels_callback, &s->ev);
+    free (level);
+    qsort (vector_eafdiff_event_begin(&s->ev), vector_eafdiff_event_size(&s->ev),
+           sizeof(eafdiff_event_t), cmp_event_x_asc);
+    s->nruns = nruns;
+}
+
+/* Integrate over [LOWER, UPPER) the positive (WA) and negative (WB) parts of
+   the difference between the EAFs of A and B, which is scaled so that
+   INTERVALS corresponds to the maximum difference. If THRESHOLD, the
+   difference counts as 1 where its absolute value is at least 1, and as 0
+   elsewhere. YA and YB are the lowest values attained at each level of A
+   and B, which are non-decreasing with the level.  */
+static void
+eafdiff_slab (const objective_t *ya, int na, const objective_t *yb, int nb,
+              int intervals, bool threshold,
+              objective_t lower, objective_t upper, double *wa, double *wb)
+{
+    const long nab = (long) na * nb;
+    int ia = 0, ib = 0;
+    objective_t prev = lower;
+    *wa = *wb = 0;
+    while (true) {
+        const objective_t next = MIN(ia < na ? ya[ia] : objective_MAX,
+                                     ib < nb ? yb[ib] : objective_MAX);
+        const objective_t top = MIN(next, upper);
+        if (top > prev) {
+            const long diff = intervals * ((long) ia * nb - (long) ib * na);
+            if (threshold) {
+                if (diff >= nab)
+                    *wa += top - prev;
+                else if (-diff >= nab)
+                    *wb += top - prev;
+            } else if (diff > 0) {
+                *wa += (top - prev) * ((double) diff / (double) nab);
+            } else if (diff < 0) {
+                *wb += (top - prev) * ((double) -diff / (double) nab);
+            }
+            prev = top;
+        }
+        if (next >= upper) return;
+        if (ia < na && ya[ia] == next)
+            ia++;
+        else
+            ib++;
+    }
+}
+
+/* Weighted hypervolume of the points X, sorted by the first objective, with
+   respect to UPPER, where the weights are the positive (WHV_A) and negative
+   (WHV_B) differences between the EAFs of A and B (see eafdiff_slab()). The
+   sweep stops at each point of the attainment surfaces and of X, so no
+   rectangles are created. YA and YB are scratch arrays of size A->nruns and
+   B->nruns.  */
+static void
+eafdiff_pair_whv (const eafdiff_levels_t *A, const eafdiff_levels_t *B,
+                  const objective_t *x, size_t nx,
+                  int intervals, bool threshold, const double *upper,
+                  objective_t *ya, objective_t *yb,
+                  double *whv_a, double *whv_b)
+{
+    const int na = A->nruns, nb = B->nruns;
+    const eafdiff_event_t *ea = vector_eafdiff_event_begin(&A->ev);
+    const eafdiff_event_t *eb = vector_eafdiff_event_begin(&B->ev);
+    const size_t nea = vector_eafdiff_event_size(&A->ev);
+    const size_t neb = vector_eafdiff_event_size(&B->ev);
+    for (int k = 0; k < na; k++) ya[k] = objective_MAX;
+    for (int k = 0; k < nb; k++) yb[k] = objective_MAX;
+    objective_t yx = objective_MAX;
+
+#define next_x() MIN(MIN(i < nea ? ea[i].x : objective_MAX,                   \
+                         j < neb ? eb[j].x : objective_MAX),                  \
+                     k < nx ? x[2 * k] : objective_MAX)
+
+    *whv_a = *whv_b = 0;
+    size_t i = 0, j = 0, k = 0;
+    while (i < nea || j < neb || k < nx) {
+        const objective_t left = next_x();
+        if (left >= upper[0]) break;
+        for (; i < nea && ea[i].x == left; i++)
+            ya[ea[i].level] = ea[i].y;
+        for (; j < neb && eb[j].x == left; j++)
+            yb[eb[j].level] = eb[j].y;
+        for (; k < nx && x[2 * k] == left; k++)
+            yx = MIN(yx, x[2 * k + 1]);
+        if (yx >= upper[1]) continue;
+        const objective_t right = MIN(upper[0], next_x());
+        double wa, wb;
+        eafdiff_slab (ya, na, yb, nb, intervals, threshold, yx, upper[1],
+                      &wa, &wb);
+        *whv_a += (right - left) * wa;
+        *whv_b += (right - left) * wb;
+    }
+#undef next_x
+}
+
+static int
+cmp_point_x_asc (const void *p1, const void *p2)
+{
+    const objective_t x1 = *(const objective_t *) p1;
+    const objective_t x2 = *(const objective_t *) p2;
+    return (x1 < x2) ? -1 : ((x1 > x2) ? 1 : 0);
+}
+
+/*
+   eafdiff_whv: weighted hypervolume of POINTS (2D only) with respect to REF,
+                where the weights are the differences between the EAF of the
+                first half of the runs in DATA and the EAF of the second half.
+
+   The weights are the colors of eafdiff_compute_rectangles(), so the result
+   is the same as rect_weighted_hv2d() with the positive rectangles (WHV[0])
+   or with the negative rectangles and their absolute color (WHV[1]), but
+   without computing the rectangles.
+*/
+void
+eafdiff_whv (double *whv, const double *points, int npoints,
+             const double *data, const int *cumsizes, int nruns,
+             int intervals, const double *ref)
+{
+    const int division = nruns / 2;
+    eafdiff_levels_t levels[2];
+    eafdiff_levels_ctor (&levels[0], data, cumsizes, division);
+    int *cum = malloc(sizeof(int) * (nruns - division));
+    for (int r = division; r < nruns; r++)
+        cum[r - division] = cumsizes[r] - cumsizes[division - 1];
+    eafdiff_levels_ctor (&levels[1], data + 2 * (size_t) cumsizes[division - 1],
+                         cum, nruns - division);
+    free (cum);
+
+    double *x = malloc(sizeof(double) * 2 * npoints);
+    memcpy(x, points, sizeof(double) * 2 * npoints);
+    qsort (x, npoints, 2 * sizeof(double), cmp_point_x_asc);
+
+    objective_t *ya = malloc(sizeof(objective_t) * nruns);
+    eafdiff_pair_whv (&levels[0], &levels[1], x, npoints, intervals, false,
+                      ref, ya, ya + division, &whv[0], &whv[1]);
+    free (ya);
+    free (x);
+    vector_eafdiff_event_dtor (&levels[0].ev);
+    vector_eafdiff_event_dtor (&levels[1].ev);
+}
+
+/*
+   largest_eafdiff: find the pair of sets of runs with the largest EAF
+                    differences (2D only).
+
+   DATA contains the points of the N sets, one after the other, and the
+   points of each run are contiguous. CUMSIZES gives the cumulative number of
+   points of each run over all sets and NRUNS the number of runs of each
+   set. The value of a pair (a, b) is the minimum of the area within [LOWER,
+   UPPER) where the EAF of a exceeds that of b by at least 1/INTERVALS and
+   the area where b exceeds a. The attainment surfaces of each set are
+   computed once and the pairs are evaluated in parallel.
+
+   Returns the largest value and stores its pair in BEST. The first pair wins
+   ties, so the result does not depend on NTHREADS.
+*/
+double
+largest_eafdiff (int *best, const double *data, const int *cumsizes,
+                 const int *nruns, int n, int intervals,
+                 const double *lower, const double *upper, int nthreads)
+{
+    eafdiff_levels_t *levels = malloc(sizeof(eafdiff_levels_t) * n);
+    int *offset = malloc(sizeof(int) * (n + 1));
+    offset[0] = 0;
+    for (int k = 0; k < n; k++)
+        offset[k + 1] = offset[k] + nruns[k];
+
+    const int npairs = n * (n - 1) / 2;
+    int *pair = malloc(sizeof(int) * 2 * npairs);
+    for (int a = 0, p = 0; a < n - 1; a++)
+        for (int b = a + 1; b < n; b++, p++) {
+            pair[2 * p] = a;
+            pair[2 * p + 1] = b;
+        }
+    double *value = malloc(sizeof(double) * npairs);
+
+    if (nthreads < 1) nthreads = 1;
+#ifdef _OPENMP
+#pragma omp parallel num_threads(nthreads) if (nthreads > 1 && n > 2)
+#endif
+    {
+#ifdef _OPENMP
+#pragma omp for schedule(dynamic, 1)
+#endif
+        for (int k = 0; k < n; k++) {
+            /* cumsizes of set k relative to its first point.  */
+            const int first = (offset[k] == 0) ? 0 : cumsizes[offset[k] - 1];
+            int *cum = malloc(sizeof(int) * nruns[k]);
+            for (int r = 0; r < nruns[k]; r++)
+                cum[r] = cumsizes[offset[k] + r] - first;
+            eafdiff_levels_ctor (&levels[k], data + 2 * (size_t) first, cum,
+                                 nruns[k]);
+            free (cum);
+        }
+
+        int maxruns = 0;
+        for (int k = 0; k < n; k++)
+            maxruns = MAX(maxruns, nruns[k]);
+        objective_t *ya = malloc(sizeof(objective_t) * maxruns);
+        objective_t *yb = malloc(sizeof(objective_t) * maxruns);
+#ifdef _OPENMP
+#pragma omp for schedule(dynamic, 1)
+#endif
+        for (int p = 0; p < npairs; p++) {
+            const int a = pair[2 * p], b = pair[2 * p + 1];
+            double area_a, area_b;
+            eafdiff_pair_whv (&levels[a], &levels[b], lower, 1,
+                              MIN(intervals, (nruns[a] + nruns[b]) / 2),
+                              true, upper, ya, yb, &area_a, &area_b);
+            value[p] = MIN(area_a, area_b);
+        }
+        free (ya);
+        free (yb);
+    }
+
+    double best_value = 0;
+    best[0] = 0;
+    best[1] = 1;
+    for (int p = 0; p < npairs; p++) {
+        if (value[p] > best_value) {
+            best_value = value[p];
+            best[0] = pair[2 * p];
+            best[1] = pair[2 * p + 1];
+        }
+    }
+    for (int k = 0; k < n; k++)
+        vector_eafdiff_event_dtor (&levels[k].ev);
+    free (levels);
+    free (value);
+    free (pair);
+    free (offset);
+    return best_value;
+}
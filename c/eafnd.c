@@ -0,0 +1,498 @@
+/*************************************************************************
+
+ eafnd: Compute the empirical attainment function from a sequence of
+        point sets with four or more objectives.
+
+ ---------------------------------------------------------------------
+
+    Copyright (c) 2025
+            Manuel Lopez-Ibanez <manuel.lopez-ibanez@manchester.ac.uk>
+
+ This Source Code Form is subject to the terms of the Mozilla Public
+ License, v. 2.0. If a copy of the MPL was not distributed with this
+ file, You can obtain one at https://mozilla.org/MPL/2.0/.
+
+ ----------------------------------------------------------------------
+
+ The points are swept in ascending order of the last objective.  Let p
+ be the point of run r reached by the sweep, p' its projection onto the
+ first (nobj - 1) objectives and v its last objective.  A point (q, v)
+ is a new minimal point of attainment level t iff q is a minimal point
+ of level (t - 1) of the points seen so far from the other runs, after
+ replacing each such point x by max(x, p'), and q was not attained at
+ level t before reaching v.  Hence, each step reduces to a single
+ (nobj - 1)-dimensional EAF, which is computed recursively until it can
+ be handed to eaf3d() or eaf2d().  The steps are independent of each
+ other, so they are processed in parallel.
+
+ The number of steps is the number of input points, so this is only
+ practical for a moderate number of points.
+
+*************************************************************************/
+#include "config.h"
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "eaf.h"
+#include "nondominated.h"
+
+static int
+compare_last_asc(const void *p1, const void *p2)
+{
+    const objective_t x1 = **(const objective_t **)p1;
+    const objective_t x2 = **(const objective_t **)p2;
+    return (x1 < x2) ? -1 : ((x1 > x2) ? 1 : 0);
+}
+
+static void
+eafnd_levels(const objective_t *data, int nobj, const int *cumsize, int nruns,
+             const int *attlevel, int nlevels, vector_objective *out,
+             vector_int *natt, int nthreads);
+
+typedef struct {
+    const objective_t *x; /* The points sorted by the last objective. */
+    const int *run;       /* The run of each point in X. */
+    const int *runpos;    /* The positions in X of the points of each run... */
+    const int *runstart;  /* ...start at RUNPOS[RUNSTART[k]]. */
+    int nobj;
+    int nruns;
+    const int *attlevel;
+    int nlevels;
+} eafnd_sweep_t;
+
+/* Number of runs with a point among the first N points of the sweep that
+   weakly dominates Q in all but the last objective, stopping at LIMIT.  */
+static int
+count_attained(const eafnd_sweep_t *s, int n, const objective_t *q,
+               bool *seen, int limit)
+{
+    const int nobj = s->nobj;
+    const dimension_t dim = (dimension_t) (nobj - 1);
+    int count = 0;
+    memset(seen, 0, s->nruns * sizeof(*seen));
+    for (int j = 0; j < n; j++) {
+        const int k = s->run[j];
+        if (seen[k] || !weakly_dominates(s->x + j * nobj, q, dim))
+            continue;
+        seen[k] = true;
+        if (++count >= limit)
+            break;
+    }
+    return count;
+}
+
+typedef struct {
+    objective_t *clipped;
+    int *subcum;
+    int *sublevel;
+    int *sub2level;
+    int *count;
+    signed char *minmax;
+    bool *seen;
+    vector_objective *cand;
+    vector_int *cand_natt;
+} eafnd_work_t;
+
+/* Whether run K has a point among the first N points of the sweep that
+   weakly dominates Q in all but the last objective.  */
+static bool
+run_attains(const eafnd_sweep_t *s, int k, int n, const objective_t *q)
+{
+    for (int j = s->runstart[k]; j < s->runstart[k + 1]; j++) {
+        const int pos = s->runpos[j];
+        if (pos >= n)
+            break;
+        if (weakly_dominates(s->x + pos * s->nobj, q, (dimension_t) (s->nobj - 1)))
+            return true;
+    }
+    return false;
+}
+
+/* Process the points [g0, g1) of the sweep, which share the same value of
+   the last objective, and append the new minimal points of each level to
+   OUT, together with the index of their level in LEV and, if NATT is not
+   NULL, the number of runs that attain them.  */
+static void
+eafnd_step(const eafnd_sweep_t *s, int g0, int g1, eafnd_work_t *w,
+           vector_objective *out, vector_int *lev, vector_int *natt)
+{
+    const int nobj = s->nobj, nruns = s->nruns;
+    const dimension_t dim = (dimension_t) (nobj - 1);
+    const int nlevels = s->nlevels;
+    const objective_t v = s->x[g0 * nobj + dim];
+    int maxlevel = 0;
+    for (int l = 0; l < nlevels; l++)
+        maxlevel = MAX(maxlevel, s->attlevel[l]);
+
+    for (int l = 0; l < nlevels; l++) {
+        vector_objective_clear(&w->cand[l]);
+        vector_int_clear(&w->cand_natt[l]);
+    }
+
+    for (int i = g0; i < g1; i++) {
+        const objective_t *p = s->x + i * nobj;
+        const int r = s->run[i];
+
+        /* Every new point dominates P', so nothing new can be found at the
+           levels that already attain P'.  */
+        const int prev = count_attained(s, g0, p, w->seen, maxlevel);
+        if (prev >= maxlevel)
+            continue;
+
+        /* Skip P if another point of its run reached so far dominates it,
+           since any point attained thanks to P is already attained.  */
+        bool redundant = false;
+        for (int j = 0; j < g1 && !redundant; j++)
+            redundant = (j != i && s->run[j] == r
+                         && weakly_dominates(s->x + j * nobj, p, (dimension_t) nobj)
+                         && (j < i || !weakly_dominates(p, s->x + j * nobj, (dimension_t) nobj)));
+        if (redundant)
+            continue;
+
+        /* Points of the other runs reached so far, replaced by their
+           component-wise maximum with P'.  A run that attains P' attains
+           every candidate, so it is counted in NCOLLAPSED instead.  */
+        int *count = w->count;
+        bool *collapsed = w->seen;
+        for (int k = 0; k < nruns; k++) {
+            count[k] = 0;
+            collapsed[k] = false;
+        }
+        for (int j = 0; j < g1; j++) {
+            const int k = s->run[j];
+            if (k == r || collapsed[k]) continue;
+            count[k]++;
+            if (weakly_dominates(s->x + j * nobj, p, dim))
+                collapsed[k] = true;
+        }
+        int sub_nruns = 0, npoints = 0, ncollapsed = 0;
+        for (int k = 0; k < nruns; k++) {
+            if (collapsed[k]) {
+                ncollapsed++;
+                continue;
+            }
+            if (count[k] == 0) continue;
+            const int start = npoints;
+            npoints += count[k];
+            count[k] = start;
+            w->subcum[sub_nruns++] = npoints;
+        }
+        for (int j = 0; j < g1; j++) {
+            const int k = s->run[j];
+            if (k == r || collapsed[k]) continue;
+            objective_t *c = w->clipped + count[k] * dim;
+            const objective_t *x = s->x + j * nobj;
+            for (int d = 0; d < dim; d++)
+                c[d] = MAX(x[d], p[d]);
+            count[k]++;
+        }
+        /* Clipping makes many points dominated by others of the same run,
+           and removing them makes the subproblem much smaller.  */
+        npoints = 0;
+        for (int k = 0, start = 0; k < sub_nruns; k++) {
+            const int size = w->subcum[k] - start;
+            objective_t *block = w->clipped + start * dim;
+            const int new_size = (size == 1) ? 1 : (int) filter_dominated_set(
+                block, dim, (size_t) size, w->minmax);
+            memmove(w->clipped + npoints * dim, block,
+                    new_size * dim * sizeof(objective_t));
+            start = w->subcum[k];
+            npoints += new_size;
+            w->subcum[k] = npoints;
+        }
+
+        int nsub = 0;
+        for (int l = 0; l < nlevels; l++) {
+            const int t = s->attlevel[l];
+            const int need = t - 1 - ncollapsed;
+            if (t <= prev) {
+                continue;
+            } else if (need <= 0) {
+                for (int d = 0; d < dim; d++)
+                    vector_objective_push_back(&w->cand[l], p[d]);
+                vector_int_push_back(&w->cand_natt[l], ncollapsed);
+            } else if (need <= sub_nruns) {
+                w->sublevel[nsub] = need;
+                w->sub2level[nsub] = l;
+                nsub++;
+            }
+        }
+        if (nsub == 0)
+            continue;
+
+        vector_objective *sub = malloc(nsub * sizeof(vector_objective));
+        vector_int *sub_natt = malloc(nsub * sizeof(vector_int));
+        for (int l = 0; l < nsub; l++) {
+            vector_objective_ctor(&sub[l], 0);
+            vector_int_ctor(&sub_natt[l], 0);
+        }
+        eafnd_levels(w->clipped, dim, w->subcum, sub_nruns, w->sublevel, nsub,
+                     sub, sub_natt, 1);
+        for (int l = 0; l < nsub; l++) {
+            const int ll = w->sub2level[l];
+            const objective_t *q = vector_objective_begin(&sub[l]);
+            const size_t n = vector_objective_size(&sub[l]);
+            for (size_t j = 0; j < n; j++)
+                vector_objective_push_back(&w->cand[ll], q[j]);
+            for (size_t j = 0; j < vector_int_size(&sub_natt[l]); j++)
+                vector_int_push_back(&w->cand_natt[ll],
+                                     ncollapsed + vector_int_at(&sub_natt[l], j));
+            vector_objective_dtor(&sub[l]);
+            vector_int_dtor(&sub_natt[l]);
+        }
+        free(sub_natt);
+        free(sub);
+    }
+
+    for (int l = 0; l < nlevels; l++) {
+        const int t = s->attlevel[l];
+        objective_t *q = vector_objective_begin(&w->cand[l]);
+        const int n = (int) (vector_objective_size(&w->cand[l]) / dim);
+        /* Discard points attained before reaching V.  With a single new
+           point P, this happens iff they are attained by more than (t - 1)
+           of the other runs or by P's run before reaching V.  */
+        const int *cnatt = vector_int_begin(&w->cand_natt[l]);
+        int m = 0;
+        for (int j = 0; j < n; j++) {
+            if (g1 - g0 == 1) {
+                if (cnatt[j] > t - 1 || run_attains(s, s->run[g0], g0, q + j * dim))
+                    continue;
+            } else if (count_attained(s, g0, q + j * dim, w->seen, t) >= t)
+                continue;
+            if (m != j)
+                memmove(q + m * dim, q + j * dim, dim * sizeof(objective_t));
+            m++;
+        }
+        /* With a single new point, the candidates are already the minimal
+           points, otherwise remove duplicated and dominated ones.  */
+        for (int j = 0; j < m; j++) {
+            const objective_t *a = q + j * dim;
+            bool dominated = false;
+            for (int k = 0; k < m && g1 - g0 > 1; k++) {
+                const objective_t *b = q + k * dim;
+                if (k != j && weakly_dominates(b, a, dim)
+                    && (k < j || !weakly_dominates(a, b, dim))) {
+                    dominated = true;
+                    break;
+                }
+            }
+            if (dominated)
+                continue;
+            for (int d = 0; d < dim; d++)
+                vector_objective_push_back(out, a[d]);
+            vector_objective_push_back(out, v);
+            vector_int_push_back(lev, l);
+            if (natt) {
+                objective_t *z = vector_objective_end(out) - nobj;
+                vector_int_push_back(natt, count_attained(s, g1, z, w->seen, nruns));
+            }
+        }
+    }
+}
+
+static void
+eafnd_sweep(const objective_t *data, int nobj, const int *cumsize, int nruns,
+            const int *attlevel, int nlevels, vector_objective *out,
+            vector_int *natt, int nthreads)
+{
+    const int ntotal = cumsize[nruns - 1];
+
+    /* Sort pointers to the last objective so that the comparison does not
+       depend on NOBJ.  */
+    const objective_t **order = malloc(ntotal * sizeof(objective_t *));
+    for (int j = 0; j < ntotal; j++)
+        order[j] = data + j * nobj + (nobj - 1);
+    qsort(order, ntotal, sizeof(*order), compare_last_asc);
+
+    /* Copy the points in sweep order, which is the order in which every
+       step scans them.  */
+    objective_t *x = malloc(ntotal * nobj * sizeof(objective_t));
+    int *run = malloc(ntotal * sizeof(int));
+    int ngroups = 0;
+    int *group = malloc((ntotal + 1) * sizeof(int));
+    for (int j = 0; j < ntotal; j++) {
+        const int i = (int) ((order[j] - data) / nobj);
+        int k = 0;
+        while (cumsize[k] <= i) k++;
+        run[j] = k;
+        memcpy(x + j * nobj, data + i * nobj, nobj * sizeof(objective_t));
+        if (j == 0 || *order[j] != *order[j - 1])
+            group[ngroups++] = j;
+    }
+    group[ngroups] = ntotal;
+    free(order);
+
+    int *runstart = calloc(nruns + 1, sizeof(int));
+    int *runpos = malloc(ntotal * sizeof(int));
+    for (int j = 0; j < ntotal; j++)
+        runstart[run[j] + 1]++;
+    for (int k = 0; k < nruns; k++)
+        runstart[k + 1] += runstart[k];
+    int *next = malloc(nruns * sizeof(int));
+    memcpy(next, runstart, nruns * sizeof(int));
+    for (int j = 0; j < ntotal; j++)
+        runpos[next[run[j]]++] = j;
+    free(next);
+
+    const eafnd_sweep_t s = { x, run, runpos, runstart, nobj, nruns,
+                              attlevel, nlevels };
+    vector_objective *gout = malloc(ngroups * sizeof(vector_objective));
+    vector_int *glev = malloc(ngroups * sizeof(vector_int));
+    vector_int *gnatt = natt ? malloc(ngroups * sizeof(vector_int)) : NULL;
+
+    if (nthreads < 1) nthreads = 1;
+#ifdef _OPENMP
+#pragma omp parallel num_threads(nthreads) if (nthreads > 1 && ngroups > 1)
+#endif
+    {
+        eafnd_work_t w;
+        w.clipped = malloc(ntotal * (nobj - 1) * sizeof(objective_t));
+        w.subcum = malloc(nruns * sizeof(int));
+        w.count = malloc(nruns * sizeof(int));
+        w.minmax = malloc(nobj * sizeof(signed char));
+        memset(w.minmax, -1, nobj * sizeof(signed char));
+        w.sublevel = malloc(2 * nlevels * sizeof(int));
+        w.sub2level = w.sublevel + nlevels;
+        w.seen = malloc(nruns * sizeof(bool));
+        w.cand = malloc(nlevels * sizeof(vector_objective));
+        w.cand_natt = malloc(nlevels * sizeof(vector_int));
+        for (int l = 0; l < nlevels; l++) {
+            vector_objective_ctor(&w.cand[l], 0);
+            vector_int_ctor(&w.cand_natt[l], 0);
+        }
+#ifdef _OPENMP
+#pragma omp for schedule(dynamic, 1)
+#endif
+        for (int g = 0; g < ngroups; g++) {
+            vector_objective_ctor(&gout[g], 0);
+            vector_int_ctor(&glev[g], 0);
+            if (gnatt)
+                vector_int_ctor(&gnatt[g], 0);
+            eafnd_step(&s, group[g], group[g + 1], &w, &gout[g], &glev[g],
+                       gnatt ? &gnatt[g] : NULL);
+        }
+        for (int l = 0; l < nlevels; l++) {
+            vector_objective_dtor(&w.cand[l]);
+            vector_int_dtor(&w.cand_natt[l]);
+        }
+        free(w.cand_natt);
+        free(w.cand);
+        free(w.seen);
+        free(w.sublevel);
+        free(w.minmax);
+        free(w.count);
+        free(w.subcum);
+        free(w.clipped);
+    }
+
+    /* Concatenate in sweep order, so the result does not depend on the
+       number of threads.  */
+    for (int g = 0; g < ngroups; g++) {
+        const objective_t *q = vector_objective_begin(&gout[g]);
+        const size_t n = vector_int_size(&glev[g]);
+        for (size_t j = 0; j < n; j++, q += nobj) {
+            const int l = vector_int_at(&glev[g], j);
+            for (int d = 0; d < nobj; d++)
+                vector_objective_push_back(&out[l], q[d]);
+            if (gnatt)
+                vector_int_push_back(&natt[l], vector_int_at(&gnatt[g], j));
+        }
+        vector_objective_dtor(&gout[g]);
+        vector_int_dtor(&glev[g]);
+        if (gnatt)
+            vector_int_dtor(&gnatt[g]);
+    }
+    free(gnatt);
+    free(glev);
+    free(gout);
+    free(runpos);
+    free(runstart);
+    free(group);
+    free(run);
+    free(x);
+}
+
+/* Append to OUT[l] the minimal points of attainment level ATTLEVEL[l] and,
+   if NATT is not NULL, to NATT[l] the number of runs that attain each of
+   them.  */
+static void
+eafnd_levels(const objective_t *data, int nobj, const int *cumsize, int nruns,
+             const int *attlevel, int nlevels, vector_objective *out,
+             vector_int *natt, int nthreads)
+{
+    if (nobj > 3) {
+        eafnd_sweep(data, nobj, cumsize, nruns, attlevel, nlevels, out, natt,
+                    nthreads);
+        return;
+    }
+    const size_t size = (size_t) cumsize[nruns - 1] * nobj;
+    objective_t *copy = malloc(size * sizeof(objective_t));
+    memcpy(copy, data, size * sizeof(objective_t));
+    eaf_t **eaf = attsurf(copy, nobj, cumsize, nruns, attlevel, nlevels, nthreads);
+    for (int l = 0; l < nlevels; l++) {
+        const size_t n = eaf[l]->size * nobj;
+        for (size_t j = 0; j < n; j++)
+            vector_objective_push_back(&out[l], eaf[l]->data[j]);
+        if (natt)
+            for (size_t j = 0; j < eaf[l]->size; j++)
+                vector_int_push_back(&natt[l], (int) bit_array_count_range(
+                    bit_array_offset(eaf[l]->bit_attained, j, nruns), 0, nruns));
+    }
+    eaf_free(eaf, nlevels);
+    free(copy);
+}
+
+eaf_t **
+eafnd (const objective_t *data, int nobj, const int *cumsize, int nruns,
+       const int *attlevel, const int nlevels, int nthreads)
+{
+    assert(nobj > 3);
+    const int ntotal = cumsize[nruns - 1];
+    DEBUG1(/* Sanity check. */
+        for (int i = 1; i < nruns ; i++)
+            assert(cumsize[i-1] < cumsize[i]);
+        );
+
+    vector_objective *out = malloc(nlevels * sizeof(vector_objective));
+    for (int l = 0; l < nlevels; l++)
+        vector_objective_ctor(&out[l], 0);
+    eafnd_levels(data, nobj, cumsize, nruns, attlevel, nlevels, out, NULL,
+                 nthreads);
+
+    eaf_t **eaf = malloc(nlevels * sizeof(eaf_t*));
+    if (nthreads < 1) nthreads = 1;
+#ifdef _OPENMP
+#pragma omp parallel num_threads(nthreads) if (nthreads > 1 && nlevels > 1)
+#endif
+    {
+        int * attained = malloc(nruns * sizeof(int));
+#ifdef _OPENMP
+#pragma omp for schedule(dynamic, 1)
+#endif
+        for (int l = 0; l < nlevels; l++) {
+            eaf[l] = eaf_create (nobj, nruns, ntotal);
+            const objective_t *q = vector_objective_begin(&out[l]);
+            const size_t n = vector_objective_size(&out[l]) / nobj;
+            for (size_t i = 0; i < n; i++, q += nobj) {
+                for (int k = 0, j = 0; k < nruns; k++) {
+                    attained[k] = 0;
+                    for (; j < cumsize[k]; j++) {
+                        if (weakly_dominates(data + j * nobj, q, (dimension_t) nobj)) {
+                            attained[k] = 1;
+                            j = cumsize[k];
+                            break;
+                        }
+                    }
+                }
+                objective_t *pos = eaf_store_point_help (eaf[l], nobj, attained);
+                memcpy(pos, q, nobj * sizeof(objective_t));
+                eaf[l]->size++;
+            }
+            vector_objective_dtor(&out[l]);
+        }
+        free(attained);
+    }
+    free(out);
+    return eaf;
+}
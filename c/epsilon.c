@@ -81,86 +81,136 @@ OPTION_MAXIMISE_STR
 " -s, --suffix=STRING  Create an output file for each input file by appending\n"
 "                      this suffix. This is ignored when reading from stdin. \n"
 "                      If missing, output is sent to stdout.                 \n"
+OPTION_JOBS_STR
 "\n", str_is_default(additive_flag), str_is_default(!additive_flag));
 }
 
+static double
+compute_epsilon (const double *points, int size, int nobj,
+                 const signed char * minmax, const double *reference,
+                 size_t reference_size)
+{
+    return (additive_flag)
+        ? epsilon_additive_minmax (nobj, minmax, points, size,
+                                   reference, (int) reference_size)
+        : epsilon_mult_minmax (nobj, minmax, points, size,
+                               reference, (int) reference_size);
+}
+
 static void
-do_file (const char *filename, double *reference, size_t reference_size,
-         int *nobj_p, const signed char * minmax, bool maximise_all_flag)
+non_positive_error (const char *filename)
 {
-    double *data = NULL;
-    int *cumsizes = NULL;
-    int nruns = 0;
-    int nobj = *nobj_p;
+    errprintf("cannot calculate multiplicative epsilon indicator with non-positive values when reading '%s'.", filename);
+    exit(EXIT_FAILURE);
+}
 
-    handle_read_data_error(
-        read_double_data (filename, &data, &nobj, &cumsizes, &nruns), filename);
-    if (!filename)
-        filename = stdin_name;
+static void
+check_all_positive (const double *points, int size, int nobj, const char *filename)
+{
+    if (!additive_flag && !all_positive(points, size, (dimension_t) nobj))
+        non_positive_error(filename);
+}
 
-    if (!additive_flag && !all_positive(data, cumsizes[nruns - 1], (dimension_t) nobj)) {
-        errprintf("cannot calculate multiplicative epsilon indicator with non-positive values when reading '%s'.", filename);
-        exit(EXIT_FAILURE);
+static void
+print_epsilon (outbuf_t *out, double epsilon, const char *filename)
+{
+    outbuf_point (out, epsilon);
+    outbuf_putc (out, '\n');
+    if ((additive_flag && epsilon < 0) || (!additive_flag && epsilon < 1)) {
+        outbuf_free (out);
+        errprintf ("%s: some points are not  dominated by the reference set",
+                   filename);
+        exit (EXIT_FAILURE);
     }
+}
 
-    char *outfilename = NULL;
-    FILE *outfile = stdout;
-    if (filename != stdin_name && suffix) {
-        outfilename = m_strcat(filename, suffix);
-        outfile = fopen (outfilename, "w");
-        if (outfile == NULL) {
-            errprintf ("%s: %s\n", outfilename, strerror(errno));
-            exit (EXIT_FAILURE);
-        }
-    }
-#if 0
-    if (union_flag) {
-        cumsizes[0] = cumsizes[nruns - 1];
-        nruns = 1;
-    }
-#endif
-    /* Default minmax if not set yet.  */
-    bool free_minmax = false;
-    if (minmax == NULL) {
-        minmax = maximise_all_flag ? minmax_maximise(nobj) : minmax_minimise(nobj);
-        free_minmax = true;
-    }
+/* Calculate and print the epsilon indicator of each set of FILENAME, reading
+   one set at a time.  The values are printed once the whole file has been
+   read, so that the output and errors are the same as in do_files().  */
+static void
+do_file (const char *filename, const double *reference, size_t reference_size,
+         int *nobj_p, const signed char * minmax)
+{
+    dataset_reader_t *reader = open_dataset_reader(filename);
+    const double *points;
+    int size = 0;
+    read_next_set(reader, filename, &points, nobj_p, &size);
+    if (!filename)
+        filename = stdin_name;
 
+    bool positive = true;
+    vector_double values;
+    vector_double_ctor_zero(&values);
+    do {
+        /* After a set with non-positive values, only check the rest of the
+           file for errors.  */
+        if (!additive_flag && positive)
+            positive = all_positive(points, size, (dimension_t) *nobj_p);
+        if (positive)
+            vector_double_push_back(&values,
+                                    compute_epsilon(points, size, *nobj_p, minmax,
+                                                    reference, reference_size));
+    } while (read_next_set(reader, filename, &points, nobj_p, &size));
+    dataset_reader_close(reader);
+
+    if (!positive)
+        non_positive_error(filename);
+    char *outfilename;
+    FILE *outfile = open_output_file(filename, suffix, &outfilename);
     if (verbose_flag)
         printf("# file: %s\n", filename);
+    outbuf_t *out = outbuf_new(outfile);
+    for (size_t n = 0; n < vector_double_size(&values); n++)
+        print_epsilon(out, vector_double_at(&values, n), filename);
+    outbuf_free(out);
+    close_output_file(outfile, filename, outfilename, verbose_flag);
+    vector_double_dtor(&values);
+}
 
-    for (int n = 0, cumsize = 0; n < nruns; cumsize = cumsizes[n], n++) {
-        // double time_elapsed = 0;
-        //Timer_start ();
-        double epsilon = (additive_flag)
-            ? epsilon_additive_minmax (nobj,  minmax,
-                                       &data[nobj * cumsize], cumsizes[n] - cumsize,
-                                       reference, (int) reference_size)
-            : epsilon_mult_minmax (nobj,  minmax,
-                                   &data[nobj * cumsize], cumsizes[n] - cumsize,
-                                   reference, (int) reference_size);
-        //        time_elapsed = Timer_elapsed_virtual ();
-        fprintf (outfile, indicator_printf_format "\n", epsilon);
-        if ((additive_flag && epsilon < 0) || (!additive_flag && epsilon < 1)) {
-            errprintf ("%s: some points are not  dominated by the reference set",
-                       filename);
-            exit (EXIT_FAILURE);
-        }/*
-        if (verbose_flag)
-            fprintf (outfile, "# Time: %f seconds\n", time_elapsed);
-         */
+/* Calculate and print the epsilon indicator of each set of NFILES input files
+   read by read_input_files(), computing the sets in parallel with up to
+   NTHREADS threads.  */
+static void
+do_files (input_file_t *files, int nfiles, const double *reference,
+          size_t reference_size, int nobj, const signed char * minmax,
+          int nthreads)
+{
+    int nsets;
+    int *set_file = input_files_sets(files, nfiles, &nsets);
+    double *values = malloc(sizeof(double) * MAX(nsets, 1));
+    if (nthreads < 1) nthreads = 1;
+#ifdef _OPENMP
+#pragma omp parallel for schedule(dynamic, 1) num_threads(nthreads) if (nthreads > 1 && nsets > 1)
+#endif
+    for (int t = 0; t < nsets; t++) {
+        const input_file_t *file = files + set_file[t];
+        const int n = t - file->first_set;
+        const int cumsize = (n == 0) ? 0 : file->cumsizes[n - 1];
+        values[t] = compute_epsilon(&file->data[nobj * cumsize],
+                                    file->cumsizes[n] - cumsize, nobj, minmax,
+                                    reference, reference_size);
     }
 
-    if (outfilename) {
+    for (int k = 0; k < nfiles; k++) {
+        const input_file_t *file = files + k;
+        const char *filename = file->filename;
+        handle_read_data_error(file->err, filename);
+        if (!filename)
+            filename = stdin_name;
+
+        check_all_positive(file->data, file->cumsizes[file->nruns - 1], nobj, filename);
+        char *outfilename;
+        FILE *outfile = open_output_file(filename, suffix, &outfilename);
         if (verbose_flag)
-            fprintf (stderr, "# %s -> %s\n", filename, outfilename);
-        fclose (outfile);
-        free (outfilename);
+            printf("# file: %s\n", filename);
+        outbuf_t *out = outbuf_new(outfile);
+        for (int n = 0; n < file->nruns; n++)
+            print_epsilon(out, values[file->first_set + n], filename);
+        outbuf_free(out);
+        close_output_file(outfile, filename, outfilename, verbose_flag);
     }
-    free (data);
-    free (cumsizes);
-    if (free_minmax) free( (void *) minmax);
-    *nobj_p = nobj;
+    free (values);
+    free (set_file);
 }
 
 int main(int argc, char *argv[])
@@ -171,9 +221,10 @@ int main(int argc, char *argv[])
     const signed char *minmax = NULL;
     bool maximise_all_flag = false;
     int nobj = 0, tmp_nobj = 0;
+    int nthreads = 1;
 
     /* see the man page for getopt_long for an explanation of these fields */
-    static const char short_options[] = "hVvqamMr:s:o:";
+    static const char short_options[] = "hVvqamMr:s:o:j:";
     static const struct option long_options[] = {
         {"help",       no_argument,       NULL, 'h'},
         {"version",    no_argument,       NULL, 'V'},
@@ -187,6 +238,7 @@ int main(int argc, char *argv[])
         {"reference",  required_argument, NULL, 'r'},
         {"suffix",     required_argument, NULL, 's'},
         {"obj",        required_argument, NULL, 'o'},
+        {"jobs",       required_argument, NULL, 'j'},
         {NULL, 0, NULL, 0} /* marks end of list */
     };
 
@@ -235,6 +287,10 @@ int main(int argc, char *argv[])
             suffix = optarg;
             break;
 
+        case 'j': // --jobs
+            nthreads = parse_cmdline_jobs(optarg);
+            break;
+
         case 'q': // --quiet
             verbose_flag = false;
             break;
@@ -273,35 +329,30 @@ int main(int argc, char *argv[])
         exit(EXIT_FAILURE);
     }
     int numfiles = argc - optind;
-    if (numfiles < 1) { /* Read stdin.  */
-        do_file (NULL, reference, reference_size, &nobj, minmax, maximise_all_flag);
-    } else if (numfiles == 1) {
-        do_file (argv[optind], reference, reference_size, &nobj, minmax, maximise_all_flag);
+    const char *stdin_file[] = { NULL };
+    const char **filenames = (numfiles < 1) /* Read stdin.  */
+        ? stdin_file : (const char **) argv + optind;
+    if (numfiles < 1)
+        numfiles = 1;
+
+    /* FIXME: Calculate the nondominated front among all input files to use
+       as reference set.  */
+    if (nthreads == 1) {
+        for (int k = 0; k < numfiles; k++)
+            do_file (filenames[k], reference, reference_size, &nobj, minmax);
     } else {
-        int k;
-        /* FIXME: Calculate the nondominated front among all input
-           files to use as reference set.  */
-#if 0
-        if (reference == NULL) {
-            reference_size =
-                calculate_nondominated (&reference, data, nobj, cumsizes[nruns-1],
-                                        minmax);
-            write_sets (stderr, reference, nobj, &reference_size, 1);
+        /* Read just enough files at once to keep all threads busy.  */
+        const int batch = input_files_batch(numfiles, nthreads);
+        input_file_t *files = malloc(sizeof(input_file_t) * batch);
+        for (int start = 0; start < numfiles; start += batch) {
+            int nfiles = MIN(batch, numfiles - start);
+            for (int k = 0; k < nfiles; k++)
+                files[k] = (input_file_t) { .filename = filenames[start + k] };
+            read_input_files(files, nfiles, &nobj, false, nthreads);
+            do_files (files, nfiles, reference, reference_size, nobj, minmax, nthreads);
+            input_files_free(files, nfiles);
         }
-        for (k = 0; k < numfiles; k++)
-            nondominatedfile_range (argv[optind + k], &maximum, &minimum, &nobj);
-
-        if (verbose_flag >= 2) {
-            printf ("# maximum:");
-            vector_printf (maximum, nobj);
-            printf ("\n");
-            printf ("# minimum:");
-            vector_printf (minimum, nobj);
-            printf ("\n");
-        }
-#endif
-        for (k = 0; k < numfiles; k++)
-            do_file (argv[optind + k], reference, reference_size, &nobj, minmax, maximise_all_flag);
+        free(files);
     }
 
     free(reference);
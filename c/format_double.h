@@ -0,0 +1,184 @@
+#ifndef FORMAT_DOUBLE_H
+#define FORMAT_DOUBLE_H
+/*************************************************************************
+
+ Fast conversion of double to the shortest decimal string that reads back
+ as the same double.
+
+ format_double() writes the value rounded to 15 significant digits if that
+ reads back as the same double, otherwise to 16 or 17 digits, thus it never
+ loses precision.  The output is the same as printf("%.15g") whenever the
+ latter reads back as the same double (which is the case for any value read
+ from a decimal string with at most 15 significant digits).
+
+ The 17 significant digits are computed with the 128-bit powers of ten used
+ by parse_double() and each candidate is checked by converting it back with
+ decimal_to_double().  Values that cannot be handled this way (subnormal
+ numbers) are formatted with snprintf().
+
+*************************************************************************/
+#include <math.h>
+#include <stdio.h>
+#include "parse_double.h"
+
+/* Size of a buffer large enough for any output of format_double().  */
+#define FORMAT_DOUBLE_MAXLEN 32
+
+/* Compute the first 17 significant digits of the normal double V > 0, that
+   is, V * 10^(16 - *EXP10_P) ~= *DIGITS_P + *FRAC_P / 2^64, with *DIGITS_P in
+   [10^16, 10^17).  */
+static inline bool
+double_to_decimal17(double v, uint64_t * digits_p, uint64_t * frac_p, int * exp10_p)
+{
+    uint64_t bits;
+    memcpy(&bits, &v, sizeof(bits));
+    const int biased_exp = (int) ((bits >> 52) & 0x7FF);
+    if (biased_exp == 0)
+        return false;
+    const uint64_t man = (bits & UINT64_C(0x000FFFFFFFFFFFFF)) | (UINT64_C(1) << 52);
+    const int exp2 = biased_exp - 1075; // V = man * 2^exp2
+    // 78913 / 2^18 ~= log10(2), thus exp10 = floor(log10(2^(exp2 + 52))),
+    // which is either the decimal exponent of V or one less.
+    int exp10 = ((exp2 + 52) * 78913) >> 18;
+    for (int attempt = 0; attempt < 2; attempt++) {
+        const int q = 16 - exp10;
+        if (q < POW10_MANTISSA_MIN_EXP10 || q > POW10_MANTISSA_MAX_EXP10)
+            return false;
+        // 10^q ~= pow10 * 2^(floor(log2(10^q)) - 127)
+        const uint64_t * pow10 = pow10_mantissa[q - POW10_MANTISSA_MIN_EXP10];
+        // 192-bit product P = man * pow10, as p2:p1 (the lowest 64 bits do
+        // not matter).
+        uint64_t a_lo, a_hi = mul_u64_hi_lo(man, pow10[1], &a_lo);
+        uint64_t b_lo, b_hi = mul_u64_hi_lo(man, pow10[0], &b_lo);
+        const uint64_t p1 = b_lo + a_hi;
+        const uint64_t p2 = b_hi + (p1 < b_lo);
+        (void) a_lo;
+        // V * 10^q = P >> shift, thus p2:p1 >> (shift - 64).
+        const int shift = -(exp2 + ((217706 * q) >> 16) - 127) - 64;
+        if (shift <= 0 || shift > 64)
+            return false;
+        const uint64_t digits = (shift == 64) ? p2 : (p2 << (64 - shift)) | (p1 >> shift);
+        if (digits >= UINT64_C(100000000000000000)) {
+            exp10++;
+        } else if (digits < UINT64_C(10000000000000000)) {
+            exp10--;
+        } else {
+            *digits_p = digits;
+            *frac_p = (shift == 64) ? p1 : p1 << (64 - shift);
+            *exp10_p = exp10;
+            return true;
+        }
+    }
+    return false;
+}
+
+/* Write the NDIGITS digits of DIGITS, without trailing zeros, to BUF as
+   printf("%g") would do for a number with decimal exponent EXP10, that is,
+   in scientific notation if EXP10 < -4 or EXP10 >= 15.  */
+static inline char *
+format_decimal(char * buf, uint64_t digits, int ndigits, int exp10)
+{
+    char d[20];
+    for (int i = ndigits - 1; i >= 0; i--) {
+        d[i] = (char) ('0' + digits % 10);
+        digits /= 10;
+    }
+    while (ndigits > 1 && d[ndigits - 1] == '0')
+        ndigits--;
+
+    char * p = buf;
+    if (exp10 < -4 || exp10 >= 15) {
+        *p++ = d[0];
+        if (ndigits > 1) {
+            *p++ = '.';
+            memcpy(p, d + 1, (size_t) ndigits - 1);
+            p += ndigits - 1;
+        }
+        *p++ = 'e';
+        *p++ = (exp10 < 0) ? '-' : '+';
+        unsigned e = (unsigned) ((exp10 < 0) ? -exp10 : exp10);
+        if (e >= 100)
+            *p++ = (char) ('0' + e / 100);
+        *p++ = (char) ('0' + (e / 10) % 10);
+        *p++ = (char) ('0' + e % 10);
+    } else if (exp10 < 0) {
+        *p++ = '0';
+        *p++ = '.';
+        for (int i = -1; i > exp10; i--)
+            *p++ = '0';
+        memcpy(p, d, (size_t) ndigits);
+        p += ndigits;
+    } else {
+        const int nint = exp10 + 1;
+        for (int i = 0; i < nint; i++)
+            *p++ = (i < ndigits) ? d[i] : '0';
+        if (ndigits > nint) {
+            *p++ = '.';
+            memcpy(p, d + nint, (size_t) (ndigits - nint));
+            p += ndigits - nint;
+        }
+    }
+    return p;
+}
+
+/* Write X to BUF, which must have room for FORMAT_DOUBLE_MAXLEN characters,
+   and return a pointer to the end of the output, which is not
+   NUL-terminated.  */
+static inline char *
+format_double(char * buf, double x)
+{
+    char * p = buf;
+    if (signbit(x))
+        *p++ = '-';
+    if (isnan(x)) {
+        memcpy(p, "nan", 3);
+        return p + 3;
+    }
+    if (isinf(x)) {
+        memcpy(p, "inf", 3);
+        return p + 3;
+    }
+    const double v = fabs(x);
+    if (v == 0) {
+        *p++ = '0';
+        return p;
+    }
+    uint64_t d17, frac;
+    int exp10;
+    if (double_to_decimal17(v, &d17, &frac, &exp10)) {
+        uint64_t scale = 100;
+        for (int ndigits = 15; ndigits <= 17; ndigits++, scale /= 10) {
+            // Round to nearest, ties to even, as printf() does.
+            uint64_t digits = d17 / scale;
+            const uint64_t rest = d17 % scale;
+            const uint64_t half = scale / 2; // Zero if scale == 1.
+            if (scale == 1) {
+                if (frac > (UINT64_C(1) << 63)
+                    || (frac == (UINT64_C(1) << 63) && (digits & 1)))
+                    digits++;
+            } else if (rest > half || (rest == half && (frac != 0 || (digits & 1)))) {
+                digits++;
+            }
+            int e = exp10;
+            // Rounding up may add one digit, e.g., 9.99 -> 10.0
+            if (digits >= UINT64_C(1000000000000000) * (100 / scale)) {
+                digits /= 10;
+                e++;
+            }
+            double y;
+            if (!decimal_to_double(digits, e - ndigits + 1, false, &y))
+                break;
+            if (y == v)
+                return format_decimal(p, digits, ndigits, e);
+        }
+    }
+    // Slow but safe.
+    for (int prec = 15; prec <= 17; prec++) {
+        int len = snprintf(p, FORMAT_DOUBLE_MAXLEN - 1, "%.*g", prec, v);
+        if (prec == 17 || strtod(p, NULL) == v)
+            return p + len;
+    }
+    return p; // Not reached.
+}
+
+#endif // FORMAT_DOUBLE_H
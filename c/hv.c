@@ -343,7 +343,6 @@ double hv4d(const double * restrict data, size_t n, const double * restrict ref)
 double fpli_hv(const double * restrict data, int d, int npoints,
                const double * restrict ref)
 {
-    printf("Moocore implementation of fpli_hv called.\n");
     size_t n = (size_t) npoints;
     if (unlikely(n == 0)) return 0.0;
     ASSUME(d < 256);
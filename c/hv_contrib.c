@@ -14,14 +14,18 @@
 
    With hv_total=0, it computes the negated hypervolume of each subset minus
    one point.
+
+   Point i is removed by replacing it with the reference point in a private
+   copy of the points, thus the input is not modified.
 */
 static void
-hv_1point_diffs (double *hvc, double *points, dimension_t dim, size_t size, const double * ref,
+hv_1point_diffs (double *hvc, const double *points, dimension_t dim, size_t size, const double * ref,
                  const bool * uev, const double hv_total)
 {
     bool keep_uevs = uev != NULL;
     const double tolerance = sqrt(DBL_EPSILON);
-    double * tmp = MOOCORE_MALLOC(dim, double);
+    double * work = MOOCORE_MALLOC(dim * size, double);
+    memcpy(work, points, sizeof(double) * dim * size);
     const bool * maximise = new_bool_maximise(dim, /*maximise_all=*/false);
     const bool * nondom = is_nondominated(points, dim, size, maximise,
                                           /*keep_weakly=*/false);
@@ -32,17 +36,16 @@ hv_1point_diffs (double *hvc, double *points, dimension_t dim, size_t size, cons
         } else if (unlikely(!nondom[i] || !strongly_dominates(points + i * dim, ref, dim))) {
             hvc[i] = 0.0;
         } else {
-            memcpy(tmp, points + i * dim, sizeof(double) * dim);
-            memcpy(points + i * dim, ref, sizeof(double) * dim);
-            hvc[i] = hv_total - fpli_hv(points, dim, (int) size, ref);
+            memcpy(work + i * dim, ref, sizeof(double) * dim);
+            hvc[i] = hv_total - fpli_hv(work, dim, (int) size, ref);
             // Handle very small values.
             hvc[i] = fabs(hvc[i]) >= tolerance ? hvc[i] : 0.0;
             assert(hvc[i] >= 0);
-            memcpy(points + i * dim, tmp, sizeof(double) * dim);
+            memcpy(work + i * dim, points + i * dim, sizeof(double) * dim);
         }
     }
     free((void *)nondom);
-    free(tmp);
+    free(work);
 }
 
 /* O(n log n) dimension-sweep algorithm.
@@ -143,7 +146,7 @@ hvc2d(double * restrict hvc, const double * restrict data, size_t n, const doubl
    definition of fatal_error().  */
 static inline void
 hvc_check(double hv_total, const double * restrict hvc,
-          double * restrict points,
+          const double * restrict points,
           dimension_t dim, size_t size, const double * restrict ref)
 {
     const double tolerance = sqrt(DBL_EPSILON);
@@ -169,7 +172,7 @@ hvc_check(double hv_total, const double * restrict hvc,
    reference point.
 */
 double
-hv_contributions(double * restrict hvc, double * restrict points, int d, int n,
+hv_contributions(double * restrict hvc, const double * restrict points, int d, int n,
                  const double * restrict ref)
 {
     assert(hvc != NULL);
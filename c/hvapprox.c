@@ -1,4 +1,6 @@
 #include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
 #include <stdbool.h>
 #include <math.h>
 #include "hvapprox.h"
@@ -10,6 +12,11 @@ static inline long double fractl(long double x) { return x - truncl(x); }
 
 #define ALMOST_ZERO_WEIGHT 1e-20
 
+/* Samples are processed in chunks of this size.  Each chunk uses its own
+   random stream and its own partial sum, thus the result does not depend on
+   the number of threads.  */
+#define HV_APPROX_CHUNK_SIZE 4096
+
 #ifndef M_PIl
 # define M_PIl		3.141592653589793238462643383279502884L /* pi */
 #endif
@@ -20,9 +27,11 @@ static inline long double fractl(long double x) { return x - truncl(x); }
 # define M_PI_4l	0.785398163397448309615660845819875721L /* pi/4 */
 #endif
 
+/* If INDEX is not NULL, INDEX[j] is the row of DATA of the j-th point kept.  */
 static double *
 transform_and_filter(const double * restrict data, dimension_t dim, size_t * restrict npoints_p,
-                     const double * restrict ref, const bool * restrict maximise)
+                     const double * restrict ref, const bool * restrict maximise,
+                     size_t * restrict index)
 {
     size_t npoints = *npoints_p;
     double * points = malloc(dim * npoints * sizeof(double));
@@ -38,8 +47,11 @@ transform_and_filter(const double * restrict data, dimension_t dim, size_t * res
             if (points[j * dim + k] <= 0)
                 break;
         }
-        if (k == dim)
+        if (k == dim) {
+            if (index)
+                index[j] = i;
             j++;
+        }
     }
     *npoints_p = j;
     if (*npoints_p == 0) {
@@ -49,23 +61,105 @@ transform_and_filter(const double * restrict data, dimension_t dim, size_t * res
     return points;
 }
 
-static inline double
-get_expected_value(const double * restrict points, dimension_t dim, size_t npoints,
-                   const double * restrict w)
+/* Directions are evaluated in tiles of this size.  */
+#define HV_APPROX_TILE 8
+
+/* Compute max_i (min_k points[i][k] * w[k])^dim for each direction of a tile.
+   The tile is stored by coordinate, w[k * HV_APPROX_TILE + t], so each pass
+   over the points serves all directions and the loops over the tile can be
+   vectorized.  All HV_APPROX_TILE lanes of W must be initialized, but only
+   the first NW values are returned.  */
+static inline void
+get_expected_value_tile(double * restrict value,
+                        const double * restrict points, dimension_t dim, size_t npoints,
+                        const double * restrict w, int nw)
 {
     ASSUME(1 <= dim && dim <= 32);
     ASSUME(npoints >= 1);
+    ASSUME(1 <= nw && nw <= HV_APPROX_TILE);
     // points >= 0 && w >=0 so max_s_w cannot be < 0.
-    double max_s_w = 0;
+    double max_s_w[HV_APPROX_TILE] = { 0 };
+    for (size_t i = 0; i < npoints; i++) {
+        const double * restrict p = points + i * dim;
+        double min_ratio[HV_APPROX_TILE];
+        for (int t = 0; t < HV_APPROX_TILE; t++)
+            min_ratio[t] = p[0] * w[t];
+        for (dimension_t k = 1; k < dim; k++) {
+            const double pk = p[k];
+            const double * restrict wk = w + k * HV_APPROX_TILE;
+            // Without this, GCC fully unrolls the loop and does not vectorize it.
+#ifdef _OPENMP
+#pragma omp simd
+#endif
+            for (int t = 0; t < HV_APPROX_TILE; t++)
+                min_ratio[t] = MIN(min_ratio[t], pk * wk[t]);
+        }
+#ifdef _OPENMP
+#pragma omp simd
+#endif
+        for (int t = 0; t < HV_APPROX_TILE; t++)
+            max_s_w[t] = MAX(max_s_w[t], min_ratio[t]);
+    }
+    for (int t = 0; t < nw; t++)
+        value[t] = pow_uint(max_s_w[t], dim);
+}
+
+/* Same as get_expected_value_tile(), but for each direction of the tile,
+   return the index of the point with the largest value and the difference
+   between the largest and the second largest values.  Ties give zero.  */
+static inline void
+get_contribution_tile(size_t * restrict best, double * restrict value,
+                      const double * restrict points, dimension_t dim, size_t npoints,
+                      const double * restrict w, int nw)
+{
+    ASSUME(1 <= dim && dim <= 32);
+    ASSUME(npoints >= 1);
+    ASSUME(1 <= nw && nw <= HV_APPROX_TILE);
+    double max1[HV_APPROX_TILE] = { 0 }, max2[HV_APPROX_TILE] = { 0 };
+    size_t arg[HV_APPROX_TILE] = { 0 };
     for (size_t i = 0; i < npoints; i++) {
-        double min_ratio = points[i * dim + 0] * w[0];
+        const double * restrict p = points + i * dim;
+        double min_ratio[HV_APPROX_TILE];
+        for (int t = 0; t < HV_APPROX_TILE; t++)
+            min_ratio[t] = p[0] * w[t];
         for (dimension_t k = 1; k < dim; k++) {
-            double ratio = points[i * dim + k] * w[k];
-            min_ratio = MIN(min_ratio, ratio);
+            const double pk = p[k];
+            const double * restrict wk = w + k * HV_APPROX_TILE;
+#ifdef _OPENMP
+#pragma omp simd
+#endif
+            for (int t = 0; t < HV_APPROX_TILE; t++)
+                min_ratio[t] = MIN(min_ratio[t], pk * wk[t]);
         }
-        max_s_w = MAX(max_s_w, min_ratio);
+#ifdef _OPENMP
+#pragma omp simd
+#endif
+        for (int t = 0; t < HV_APPROX_TILE; t++) {
+            const double m = min_ratio[t];
+            max2[t] = MAX(max2[t], MIN(m, max1[t]));
+            arg[t] = (m > max1[t]) ? i : arg[t];
+            max1[t] = MAX(max1[t], m);
+        }
+    }
+    for (int t = 0; t < nw; t++) {
+        best[t] = arg[t];
+        value[t] = pow_uint(max1[t], dim) - pow_uint(max2[t], dim);
     }
-    return pow_uint(max_s_w, dim);
+}
+
+/* Sum the partial sums in a fixed order, which is more accurate than a
+   sequential sum.  */
+static double
+sum_pairwise(const double * x, size_t n)
+{
+    if (n <= 8) {
+        double sum = 0;
+        for (size_t i = 0; i < n; i++)
+            sum += x[i];
+        return sum;
+    }
+    const size_t half = n / 2;
+    return sum_pairwise(x, half) + sum_pairwise(x + half, n - half);
 }
 
 #if DEBUG >= 1 // Only used for checking the product of int_all below.
@@ -151,6 +245,33 @@ static const long double sphere_area_div_2_pow_d_times_d[] = {
     0x1.20c62c2f2d7f4a970cb97b8e179a6943fd21ba7509p-50L, // d = 32, value = 1.001886461636272e-15
 };
 
+/* Generate NW random directions of a tile (see get_expected_value_tile()).  */
+static void
+normal_directions_tile(double * restrict w, dimension_t dim, int nw, rng_state * rng)
+{
+    for (int t = 0; t < nw; t++) {
+        dimension_t k;
+        // Generate random weights in positive orthant.
+        // Reference: Marsaglia, G. (1972). "Choosing a Point from the Surface
+        // of a Sphere". Annals of Mathematical Statistics. 43 (2): 645-646.
+        for (k = 0; k < dim; k++) {
+            double wk = fabs(rng_standard_normal(rng));
+            if (wk <= ALMOST_ZERO_WEIGHT) // Avoid division by zero later.
+                wk = ALMOST_ZERO_WEIGHT;
+            w[k * HV_APPROX_TILE + t] = wk;
+        }
+        double norm = 0.0;
+        for (k = 0; k < dim; k++)
+            norm += w[k * HV_APPROX_TILE + t] * w[k * HV_APPROX_TILE + t];
+        norm = sqrt(norm);
+        for (k = 0; k < dim; k++) {
+            // 1 / (w[k] / norm) so we avoid the division when calculating the
+            // ratio below.
+            w[k * HV_APPROX_TILE + t] = norm / w[k * HV_APPROX_TILE + t];
+        }
+    }
+}
+
 /* Hypervolume approximation DZ2019-MC.
 
    Jingda Deng, Qingfu Zhang (2019). “Approximating Hypervolume and Hypervolume
@@ -160,50 +281,155 @@ static const long double sphere_area_div_2_pow_d_times_d[] = {
 double
 hv_approx_normal(const double * restrict data, int nobjs, int n,
                  const double * restrict ref, const bool * restrict maximise,
-                 uint_fast32_t nsamples, uint32_t random_seed)
+                 uint_fast32_t nsamples, uint32_t random_seed, int nthreads)
 {
     ASSUME(nobjs > 1);
     ASSUME(nobjs < 32);
     ASSUME(n >= 0);
     const dimension_t dim = (dimension_t) nobjs;
     size_t npoints = (size_t) n;
-    const double * points = transform_and_filter(data, dim, &npoints, ref, maximise);
+    const double * points = transform_and_filter(data, dim, &npoints, ref, maximise, NULL);
     if (points == NULL)
         return 0;
 
-    rng_state * rng = rng_new(random_seed);
-    double * w = malloc(dim * sizeof(double));
-    double expected = 0.0;
-    // Monte Carlo sampling.
-    for (uint_fast32_t j = 0; j < nsamples; j++) {
-        dimension_t k;
-        // Generate random weights in positive orthant.
-        // Reference: Marsaglia, G. (1972). "Choosing a Point from the Surface
-        // of a Sphere". Annals of Mathematical Statistics. 43 (2): 645-646.
-        for (k = 0; k < dim; k++) {
-            w[k] = fabs(rng_standard_normal(rng));
-            if (w[k] <= ALMOST_ZERO_WEIGHT) // Avoid division by zero later.
-                w[k] = ALMOST_ZERO_WEIGHT;
-        }
-        double norm = 0.0;
-        for (k = 0; k < dim; k++)
-            norm += w[k] * w[k];
-        norm = sqrt(norm);
-        for (k = 0; k < dim; k++) {
-            // 1 / (w[k] / norm) so we avoid the division when calculating the
-            // ratio below.
-            w[k] = norm / w[k];
+    const size_t nchunks = (nsamples + HV_APPROX_CHUNK_SIZE - 1) / HV_APPROX_CHUNK_SIZE;
+    double * partial = malloc(nchunks * sizeof(double));
+    if (nthreads < 1) nthreads = 1;
+#ifdef _OPENMP
+#pragma omp parallel num_threads(nthreads) if (nthreads > 1 && nchunks > 1)
+#endif
+    {
+        rng_state * rng = rng_new(random_seed);
+        double * w = calloc(dim * HV_APPROX_TILE, sizeof(double));
+        // Monte Carlo sampling.
+#ifdef _OPENMP
+#pragma omp for schedule(dynamic, 1)
+#endif
+        for (size_t c = 0; c < nchunks; c++) {
+            rng_seed_stream(rng, random_seed, (uint32_t) c);
+            const uint_fast32_t end = MIN(nsamples, (c + 1) * HV_APPROX_CHUNK_SIZE);
+            double expected = 0.0;
+            for (uint_fast32_t j = c * HV_APPROX_CHUNK_SIZE; j < end; j += HV_APPROX_TILE) {
+                const int nw = (int) MIN((uint_fast32_t) HV_APPROX_TILE, end - j);
+                normal_directions_tile(w, dim, nw, rng);
+                double value[HV_APPROX_TILE];
+                get_expected_value_tile(value, points, dim, npoints, w, nw);
+                for (int t = 0; t < nw; t++)
+                    expected += value[t];
+            }
+            partial[c] = expected;
         }
-        expected += get_expected_value(points, dim, npoints, w);
+        free(w);
+        rng_free(rng);
     }
-    free(w);
-    free(rng);
+    const double expected = sum_pairwise(partial, nchunks);
+    free(partial);
     free((void*)points);
     const long double c_m = sphere_area_div_2_pow_d_times_d[dim];
     return STATIC_CAST(double, c_m * (expected / STATIC_CAST(long double, nsamples)));
 }
 
 
+/* At most this many chunks are sampled between two checks of the stopping
+   rule of hv_approx_normal_adaptive().  */
+#define HV_APPROX_MAX_BATCH 64
+
+/* Adaptive version of hv_approx_normal().  Chunks of directions are sampled
+   in batches, first doubling the number of chunks and then HV_APPROX_MAX_BATCH
+   chunks at a time, until the half-width Z * STD_ERROR of the confidence
+   interval is at most REL_ERROR times the estimate or MAX_NSAMPLES directions
+   have been sampled.  The mean and variance of each chunk are computed with
+   Welford's algorithm and merged in the order of the chunks, so the result
+   does not depend on the number of threads.  The directions are the same as
+   those of hv_approx_normal() with the same seed and NSAMPLES_USED.  */
+double
+hv_approx_normal_adaptive(double * restrict std_error, uint_fast32_t * restrict nsamples_used,
+                          const double * restrict data, int nobjs, int n,
+                          const double * restrict ref, const bool * restrict maximise,
+                          double rel_error, double z, uint_fast32_t max_nsamples,
+                          uint32_t random_seed, int nthreads)
+{
+    ASSUME(nobjs > 1);
+    ASSUME(nobjs < 32);
+    ASSUME(n >= 0);
+    const dimension_t dim = (dimension_t) nobjs;
+    size_t npoints = (size_t) n;
+    *std_error = 0;
+    *nsamples_used = 0;
+    const double * points = transform_and_filter(data, dim, &npoints, ref, maximise, NULL);
+    if (points == NULL)
+        return 0;
+
+    const size_t max_chunks = (max_nsamples + HV_APPROX_CHUNK_SIZE - 1) / HV_APPROX_CHUNK_SIZE;
+    double * chunk_mean = malloc(MIN(max_chunks, (size_t) HV_APPROX_MAX_BATCH) * sizeof(double));
+    double * chunk_m2 = malloc(MIN(max_chunks, (size_t) HV_APPROX_MAX_BATCH) * sizeof(double));
+    if (nthreads < 1) nthreads = 1;
+    uint_fast32_t count = 0;
+    double mean = 0, m2 = 0;
+    size_t done = 0;
+    while (done < max_chunks) {
+        const size_t batch = MIN(MIN(MAX(done, (size_t) 1), (size_t) HV_APPROX_MAX_BATCH),
+                                 max_chunks - done);
+#ifdef _OPENMP
+#pragma omp parallel num_threads(nthreads) if (nthreads > 1 && batch > 1)
+#endif
+        {
+            rng_state * rng = rng_new(random_seed);
+            double * w = calloc(dim * HV_APPROX_TILE, sizeof(double));
+#ifdef _OPENMP
+#pragma omp for schedule(dynamic, 1)
+#endif
+            for (size_t b = 0; b < batch; b++) {
+                const size_t c = done + b;
+                rng_seed_stream(rng, random_seed, (uint32_t) c);
+                const uint_fast32_t start = c * HV_APPROX_CHUNK_SIZE;
+                const uint_fast32_t end = MIN(max_nsamples, start + HV_APPROX_CHUNK_SIZE);
+                double cmean = 0, cm2 = 0;
+                for (uint_fast32_t j = start; j < end; j += HV_APPROX_TILE) {
+                    const int nw = (int) MIN((uint_fast32_t) HV_APPROX_TILE, end - j);
+                    normal_directions_tile(w, dim, nw, rng);
+                    double value[HV_APPROX_TILE];
+                    get_expected_value_tile(value, points, dim, npoints, w, nw);
+                    for (int t = 0; t < nw; t++) {
+                        const double delta = value[t] - cmean;
+                        cmean += delta / STATIC_CAST(double, j - start + (uint_fast32_t) t + 1);
+                        cm2 += delta * (value[t] - cmean);
+                    }
+                }
+                chunk_mean[b] = cmean;
+                chunk_m2[b] = cm2;
+            }
+            free(w);
+            rng_free(rng);
+        }
+        // Chan et al. (1979) update for merging the mean and variance of two samples.
+        for (size_t b = 0; b < batch; b++) {
+            const uint_fast32_t start = (done + b) * HV_APPROX_CHUNK_SIZE;
+            const uint_fast32_t nb = MIN(max_nsamples, start + HV_APPROX_CHUNK_SIZE) - start;
+            const uint_fast32_t total = count + nb;
+            const double delta = chunk_mean[b] - mean;
+            mean += delta * STATIC_CAST(double, nb) / STATIC_CAST(double, total);
+            m2 += chunk_m2[b] + delta * delta
+                * (STATIC_CAST(double, count) * STATIC_CAST(double, nb) / STATIC_CAST(double, total));
+            count = total;
+        }
+        done += batch;
+        if (count > 1) {
+            const double se = sqrt(m2 / STATIC_CAST(double, count - 1) / STATIC_CAST(double, count));
+            *std_error = se;
+            if (z * se <= rel_error * mean)
+                break;
+        }
+    }
+    free(chunk_m2);
+    free(chunk_mean);
+    free((void*)points);
+    const double c_m = STATIC_CAST(double, sphere_area_div_2_pow_d_times_d[dim]);
+    *std_error *= c_m;
+    *nsamples_used = count;
+    return c_m * mean;
+}
+
 static uint_fast32_t *
 construct_polar_a(dimension_t dim, uint_fast32_t nsamples)
 {
@@ -580,6 +806,23 @@ compute_hua_wang_direction(double * direction, dimension_t dim,
     }
 }
 
+/* Compute the directions J, ..., J + NW - 1 of a tile (see
+   get_expected_value_tile()).  THETA and DIRECTION are workspace.  */
+static void
+hua_wang_directions_tile(double * restrict w, dimension_t dim, int nw,
+                         uint_fast32_t j, uint_fast32_t nsamples,
+                         const uint_fast32_t * polar_a, const long double * int_all,
+                         long double * theta, double * direction)
+{
+    for (int t = 0; t < nw; t++) {
+        compute_polar_sample(theta, dim - 1, j + (uint_fast32_t) t, nsamples, polar_a);
+        compute_theta(theta, dim, int_all);
+        compute_hua_wang_direction(direction, dim, theta);
+        for (dimension_t k = 0; k < dim; k++)
+            w[k * HV_APPROX_TILE + t] = direction[k];
+    }
+}
+
 /* Hypervolume approximation DZ2019-HW.
 
    Jingda Deng, Qingfu Zhang (2019). “Approximating Hypervolume and Hypervolume
@@ -589,37 +832,389 @@ compute_hua_wang_direction(double * direction, dimension_t dim,
 double
 hv_approx_hua_wang(const double * restrict data, int nobjs, int n,
                    const double * restrict ref, const bool * restrict maximise,
-                   uint_fast32_t nsamples)
+                   uint_fast32_t nsamples, int nthreads)
 {
     ASSUME(nobjs > 1);
     ASSUME(nobjs < 32);
     ASSUME(n >= 0);
     const dimension_t dim = (dimension_t) nobjs;
     size_t npoints = (size_t) n;
-    const double * points = transform_and_filter(data, dim, &npoints, ref, maximise);
+    const double * points = transform_and_filter(data, dim, &npoints, ref, maximise, NULL);
     if (points == NULL)
         return 0;
 
     const long double * int_all = compute_int_all(dim - 1);
     const uint_fast32_t * polar_a = construct_polar_a(dim - 1, nsamples);
-    double expected = 0.0;
-    // FIXME: OpenMP: #pragma omp parallel
+    const size_t nchunks = (nsamples + HV_APPROX_CHUNK_SIZE - 1) / HV_APPROX_CHUNK_SIZE;
+    double * partial = malloc(nchunks * sizeof(double));
+    if (nthreads < 1) nthreads = 1;
+#ifdef _OPENMP
+#pragma omp parallel num_threads(nthreads) if (nthreads > 1 && nchunks > 1)
+#endif
     {
         long double * theta = malloc((dim - 1) * sizeof(long double));
-        double * w = malloc(dim * sizeof(double));
-        // FIXME: Add OpenMP: #pragma omp for reduction(+:expected)
-        for (uint_fast32_t j = 0; j < nsamples; j++) {
-            compute_polar_sample(theta, dim - 1, j, nsamples, polar_a);
-            compute_theta(theta, dim, int_all);
-            compute_hua_wang_direction(w, dim, theta);
-            expected += get_expected_value(points, dim, npoints, w);
+        double * direction = malloc(dim * sizeof(double));
+        double * w = calloc(dim * HV_APPROX_TILE, sizeof(double));
+#ifdef _OPENMP
+#pragma omp for schedule(dynamic, 1)
+#endif
+        for (size_t c = 0; c < nchunks; c++) {
+            const uint_fast32_t end = MIN(nsamples, (c + 1) * HV_APPROX_CHUNK_SIZE);
+            double expected = 0.0;
+            for (uint_fast32_t j = c * HV_APPROX_CHUNK_SIZE; j < end; j += HV_APPROX_TILE) {
+                const int nw = (int) MIN((uint_fast32_t) HV_APPROX_TILE, end - j);
+                hua_wang_directions_tile(w, dim, nw, j, nsamples, polar_a, int_all,
+                                         theta, direction);
+                double value[HV_APPROX_TILE];
+                get_expected_value_tile(value, points, dim, npoints, w, nw);
+                for (int t = 0; t < nw; t++)
+                    expected += value[t];
+            }
+            partial[c] = expected;
         }
         free(theta);
+        free(direction);
         free(w);
     }
+    const double expected = sum_pairwise(partial, nchunks);
+    free(partial);
     free((void *) int_all);
     free((void *) polar_a);
     free((void*)points);
     const long double c_m = sphere_area_div_2_pow_d_times_d[dim];
     return STATIC_CAST(double, c_m * (expected / STATIC_CAST(long double, nsamples)));
 }
+
+enum hvc_approx_method_t { HVC_APPROX_NORMAL, HVC_APPROX_HUA_WANG };
+
+/* Hypervolume contributions approximated along the directions of
+   hv_approx_normal() or hv_approx_hua_wang().  Along each direction, the
+   region dominated only by the point that reaches farthest from the
+   reference point is the segment between its value and the second largest
+   value, thus the contribution of each point is estimated in the same pass
+   as the hypervolume.  The contributions of each chunk are added in the
+   order of the chunks, so the result does not depend on the number of
+   threads.  */
+static void
+hvc_approx(double * restrict hvc, const double * restrict data, int nobjs, int n,
+           const double * restrict ref, const bool * restrict maximise,
+           uint_fast32_t nsamples, enum hvc_approx_method_t method,
+           uint32_t random_seed, int nthreads)
+{
+    ASSUME(nobjs > 1);
+    ASSUME(nobjs < 32);
+    ASSUME(n >= 0);
+    const dimension_t dim = (dimension_t) nobjs;
+    for (int i = 0; i < n; i++)
+        hvc[i] = 0;
+    size_t npoints = (size_t) n;
+    size_t * index = malloc(npoints * sizeof(size_t));
+    const double * points = transform_and_filter(data, dim, &npoints, ref, maximise, index);
+    if (points == NULL) {
+        free(index);
+        return;
+    }
+
+    const long double * int_all = NULL;
+    const uint_fast32_t * polar_a = NULL;
+    if (method == HVC_APPROX_HUA_WANG) {
+        int_all = compute_int_all(dim - 1);
+        polar_a = construct_polar_a(dim - 1, nsamples);
+    }
+    const size_t nchunks = (nsamples + HV_APPROX_CHUNK_SIZE - 1) / HV_APPROX_CHUNK_SIZE;
+    if (nthreads < 1) nthreads = 1;
+#ifdef _OPENMP
+#pragma omp parallel num_threads(nthreads) if (nthreads > 1 && nchunks > 1)
+#endif
+    {
+        rng_state * rng = rng_new(random_seed);
+        long double * theta = malloc((dim - 1) * sizeof(long double));
+        double * direction = malloc(dim * sizeof(double));
+        double * w = calloc(dim * HV_APPROX_TILE, sizeof(double));
+        size_t * best = malloc(HV_APPROX_CHUNK_SIZE * sizeof(size_t));
+        double * value = malloc(HV_APPROX_CHUNK_SIZE * sizeof(double));
+#ifdef _OPENMP
+#pragma omp for ordered schedule(dynamic, 1)
+#endif
+        for (size_t c = 0; c < nchunks; c++) {
+            if (method == HVC_APPROX_NORMAL)
+                rng_seed_stream(rng, random_seed, (uint32_t) c);
+            const uint_fast32_t start = c * HV_APPROX_CHUNK_SIZE;
+            const uint_fast32_t end = MIN(nsamples, start + HV_APPROX_CHUNK_SIZE);
+            for (uint_fast32_t j = start; j < end; j += HV_APPROX_TILE) {
+                const int nw = (int) MIN((uint_fast32_t) HV_APPROX_TILE, end - j);
+                if (method == HVC_APPROX_NORMAL)
+                    normal_directions_tile(w, dim, nw, rng);
+                else
+                    hua_wang_directions_tile(w, dim, nw, j, nsamples, polar_a, int_all,
+                                             theta, direction);
+                get_contribution_tile(best + (j - start), value + (j - start),
+                                      points, dim, npoints, w, nw);
+            }
+#ifdef _OPENMP
+#pragma omp ordered
+#endif
+            for (uint_fast32_t j = 0; j < end - start; j++)
+                hvc[index[best[j]]] += value[j];
+        }
+        free(value);
+        free(best);
+        free(w);
+        free(direction);
+        free(theta);
+        rng_free(rng);
+    }
+    const long double c_m = sphere_area_div_2_pow_d_times_d[dim];
+    for (size_t j = 0; j < npoints; j++) {
+        const size_t i = index[j];
+        hvc[i] = STATIC_CAST(double, c_m * (hvc[i] / STATIC_CAST(long double, nsamples)));
+    }
+    free((void *) int_all);
+    free((void *) polar_a);
+    free(index);
+    free((void*)points);
+}
+
+/* Hypervolume contributions approximation using the directions of
+   DZ2019-MC.  HVC must have space for N values.  */
+void
+hvc_approx_normal(double * restrict hvc, const double * restrict data, int nobjs, int n,
+                  const double * restrict ref, const bool * restrict maximise,
+                  uint_fast32_t nsamples, uint32_t random_seed, int nthreads)
+{
+    hvc_approx(hvc, data, nobjs, n, ref, maximise, nsamples, HVC_APPROX_NORMAL,
+               random_seed, nthreads);
+}
+
+/* Hypervolume contributions approximation using the directions of
+   DZ2019-HW.  HVC must have space for N values.  */
+void
+hvc_approx_hua_wang(double * restrict hvc, const double * restrict data, int nobjs, int n,
+                    const double * restrict ref, const bool * restrict maximise,
+                    uint_fast32_t nsamples, int nthreads)
+{
+    hvc_approx(hvc, data, nobjs, n, ref, maximise, nsamples, HVC_APPROX_HUA_WANG,
+               0, nthreads);
+}
+
+/* A precomputed set of directions.  The directions are stored in tiles, as
+   expected by get_expected_value_tile(), and already inverted (norm / w[k]),
+   so evaluating them on many sets of points does not repeat any work.  */
+struct hvapprox_directions_t {
+    dimension_t dim;
+    uint_fast32_t nsamples;
+    double * w; // ntiles * dim * HV_APPROX_TILE values.
+};
+
+static size_t
+directions_ntiles(uint_fast32_t nsamples)
+{
+    return (nsamples + HV_APPROX_TILE - 1) / HV_APPROX_TILE;
+}
+
+static hvapprox_directions_t *
+directions_alloc(dimension_t dim, uint_fast32_t nsamples)
+{
+    hvapprox_directions_t * dirs = malloc(sizeof(hvapprox_directions_t));
+    dirs->dim = dim;
+    dirs->nsamples = nsamples;
+    // Unused lanes of the last tile must be initialized.
+    dirs->w = calloc(directions_ntiles(nsamples) * dim * HV_APPROX_TILE, sizeof(double));
+    return dirs;
+}
+
+/* The same directions as hv_approx_normal() with the same NSAMPLES and
+   RANDOM_SEED.  */
+hvapprox_directions_t *
+hvapprox_directions_normal(int nobjs, uint_fast32_t nsamples, uint32_t random_seed,
+                           int nthreads)
+{
+    ASSUME(nobjs > 1);
+    ASSUME(nobjs < 32);
+    const dimension_t dim = (dimension_t) nobjs;
+    hvapprox_directions_t * dirs = directions_alloc(dim, nsamples);
+    const size_t nchunks = (nsamples + HV_APPROX_CHUNK_SIZE - 1) / HV_APPROX_CHUNK_SIZE;
+    if (nthreads < 1) nthreads = 1;
+#ifdef _OPENMP
+#pragma omp parallel num_threads(nthreads) if (nthreads > 1 && nchunks > 1)
+#endif
+    {
+        rng_state * rng = rng_new(random_seed);
+#ifdef _OPENMP
+#pragma omp for schedule(dynamic, 1)
+#endif
+        for (size_t c = 0; c < nchunks; c++) {
+            rng_seed_stream(rng, random_seed, (uint32_t) c);
+            const uint_fast32_t end = MIN(nsamples, (c + 1) * HV_APPROX_CHUNK_SIZE);
+            for (uint_fast32_t j = c * HV_APPROX_CHUNK_SIZE; j < end; j += HV_APPROX_TILE) {
+                const int nw = (int) MIN((uint_fast32_t) HV_APPROX_TILE, end - j);
+                normal_directions_tile(dirs->w + (j / HV_APPROX_TILE) * dim * HV_APPROX_TILE,
+                                       dim, nw, rng);
+            }
+        }
+        rng_free(rng);
+    }
+    return dirs;
+}
+
+/* The same directions as hv_approx_hua_wang() with the same NSAMPLES.  */
+hvapprox_directions_t *
+hvapprox_directions_hua_wang(int nobjs, uint_fast32_t nsamples, int nthreads)
+{
+    ASSUME(nobjs > 1);
+    ASSUME(nobjs < 32);
+    const dimension_t dim = (dimension_t) nobjs;
+    hvapprox_directions_t * dirs = directions_alloc(dim, nsamples);
+    const long double * int_all = compute_int_all(dim - 1);
+    const uint_fast32_t * polar_a = construct_polar_a(dim - 1, nsamples);
+    const size_t nchunks = (nsamples + HV_APPROX_CHUNK_SIZE - 1) / HV_APPROX_CHUNK_SIZE;
+    if (nthreads < 1) nthreads = 1;
+#ifdef _OPENMP
+#pragma omp parallel num_threads(nthreads) if (nthreads > 1 && nchunks > 1)
+#endif
+    {
+        long double * theta = malloc((dim - 1) * sizeof(long double));
+        double * direction = malloc(dim * sizeof(double));
+#ifdef _OPENMP
+#pragma omp for schedule(dynamic, 1)
+#endif
+        for (size_t c = 0; c < nchunks; c++) {
+            const uint_fast32_t end = MIN(nsamples, (c + 1) * HV_APPROX_CHUNK_SIZE);
+            for (uint_fast32_t j = c * HV_APPROX_CHUNK_SIZE; j < end; j += HV_APPROX_TILE) {
+                const int nw = (int) MIN((uint_fast32_t) HV_APPROX_TILE, end - j);
+                hua_wang_directions_tile(dirs->w + (j / HV_APPROX_TILE) * dim * HV_APPROX_TILE,
+                                         dim, nw, j, nsamples, polar_a, int_all,
+                                         theta, direction);
+            }
+        }
+        free(direction);
+        free(theta);
+    }
+    free((void *) int_all);
+    free((void *) polar_a);
+    return dirs;
+}
+
+void
+hvapprox_directions_free(hvapprox_directions_t * dirs)
+{
+    if (dirs == NULL)
+        return;
+    free(dirs->w);
+    free(dirs);
+}
+
+int
+hvapprox_directions_nobjs(const hvapprox_directions_t * dirs)
+{
+    return (int) dirs->dim;
+}
+
+uint_fast32_t
+hvapprox_directions_nsamples(const hvapprox_directions_t * dirs)
+{
+    return dirs->nsamples;
+}
+
+/* Hypervolume approximation using precomputed directions.  The result is the
+   same as hv_approx_normal() or hv_approx_hua_wang() with the parameters used
+   to create DIRS.  */
+double
+hv_approx_directions(const hvapprox_directions_t * restrict dirs,
+                     const double * restrict data, int nobjs, int n,
+                     const double * restrict ref, const bool * restrict maximise,
+                     int nthreads)
+{
+    ASSUME(nobjs > 1);
+    ASSUME(nobjs < 32);
+    ASSUME(n >= 0);
+    const dimension_t dim = (dimension_t) nobjs;
+    assert(dim == dirs->dim);
+    size_t npoints = (size_t) n;
+    const double * points = transform_and_filter(data, dim, &npoints, ref, maximise, NULL);
+    if (points == NULL)
+        return 0;
+
+    const uint_fast32_t nsamples = dirs->nsamples;
+    const size_t nchunks = (nsamples + HV_APPROX_CHUNK_SIZE - 1) / HV_APPROX_CHUNK_SIZE;
+    double * partial = malloc(nchunks * sizeof(double));
+    if (nthreads < 1) nthreads = 1;
+#ifdef _OPENMP
+#pragma omp parallel for schedule(dynamic, 1) num_threads(nthreads) if (nthreads > 1 && nchunks > 1)
+#endif
+    for (size_t c = 0; c < nchunks; c++) {
+        const uint_fast32_t end = MIN(nsamples, (c + 1) * HV_APPROX_CHUNK_SIZE);
+        double expected = 0.0;
+        for (uint_fast32_t j = c * HV_APPROX_CHUNK_SIZE; j < end; j += HV_APPROX_TILE) {
+            const int nw = (int) MIN((uint_fast32_t) HV_APPROX_TILE, end - j);
+            double value[HV_APPROX_TILE];
+            get_expected_value_tile(value, points, dim, npoints,
+                                    dirs->w + (j / HV_APPROX_TILE) * dim * HV_APPROX_TILE, nw);
+            for (int t = 0; t < nw; t++)
+                expected += value[t];
+        }
+        partial[c] = expected;
+    }
+    const double expected = sum_pairwise(partial, nchunks);
+    free(partial);
+    free((void*)points);
+    const long double c_m = sphere_area_div_2_pow_d_times_d[dim];
+    return STATIC_CAST(double, c_m * (expected / STATIC_CAST(long double, nsamples)));
+}
+
+/* Directions are saved in binary, in the byte order of the machine, after a
+   header with a magic string, a byte-order mark, the number of objectives
+   and the number of directions.  */
+static const char hvapprox_directions_magic[8] = { 'H','V','A','D','I','R','0','1' };
+#define HVAPPROX_DIRECTIONS_BOM UINT32_C(0x01020304)
+
+/* Returns 0 on success and -1 on error (errno is set by the failing
+   call).  */
+int
+hvapprox_directions_save(const hvapprox_directions_t * dirs, const char * filename)
+{
+    FILE * fp = fopen(filename, "wb");
+    if (fp == NULL)
+        return -1;
+    const uint32_t bom = HVAPPROX_DIRECTIONS_BOM;
+    const uint32_t dim = dirs->dim;
+    const uint64_t nsamples = dirs->nsamples;
+    const size_t size = directions_ntiles(dirs->nsamples) * dirs->dim * HV_APPROX_TILE;
+    bool ok = fwrite(hvapprox_directions_magic, sizeof(hvapprox_directions_magic), 1, fp) == 1
+        && fwrite(&bom, sizeof(bom), 1, fp) == 1
+        && fwrite(&dim, sizeof(dim), 1, fp) == 1
+        && fwrite(&nsamples, sizeof(nsamples), 1, fp) == 1
+        && fwrite(dirs->w, sizeof(double), size, fp) == size;
+    ok = (fclose(fp) == 0) && ok;
+    return ok ? 0 : -1;
+}
+
+/* Returns NULL if FILENAME cannot be read or it was not created by
+   hvapprox_directions_save() on a machine with the same byte order.  */
+hvapprox_directions_t *
+hvapprox_directions_load(const char * filename)
+{
+    FILE * fp = fopen(filename, "rb");
+    if (fp == NULL)
+        return NULL;
+    char magic[sizeof(hvapprox_directions_magic)];
+    uint32_t bom, dim;
+    uint64_t nsamples;
+    hvapprox_directions_t * dirs = NULL;
+    if (fread(magic, sizeof(magic), 1, fp) != 1
+        || memcmp(magic, hvapprox_directions_magic, sizeof(magic)) != 0
+        || fread(&bom, sizeof(bom), 1, fp) != 1 || bom != HVAPPROX_DIRECTIONS_BOM
+        || fread(&dim, sizeof(dim), 1, fp) != 1 || dim < 2 || dim >= 32
+        || fread(&nsamples, sizeof(nsamples), 1, fp) != 1
+        || nsamples == 0 || nsamples > UINT32_MAX)
+        goto fail;
+    dirs = directions_alloc((dimension_t) dim, (uint_fast32_t) nsamples);
+    const size_t size = directions_ntiles(dirs->nsamples) * dirs->dim * HV_APPROX_TILE;
+    if (fread(dirs->w, sizeof(double), size, fp) != size || fgetc(fp) != EOF) {
+        hvapprox_directions_free(dirs);
+        dirs = NULL;
+    }
+fail:
+    fclose(fp);
+    return dirs;
+}
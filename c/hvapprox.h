@@ -13,12 +13,40 @@
 extern "C" {
 #endif
 
+/* Precomputed directions that can be reused to approximate the hypervolume of
+   many sets of points.  */
+typedef struct hvapprox_directions_t hvapprox_directions_t;
+
 double hv_approx_hua_wang(const double * data, int nobjs, int npoints,
                           const double * ref, const bool * maximise,
-                          uint_fast32_t nsamples);
+                          uint_fast32_t nsamples, int nthreads);
 double hv_approx_normal(const double * data, int nobjs, int npoints,
                         const double * ref, const bool * maximise,
-                        uint_fast32_t nsamples, uint32_t random_seed);
+                        uint_fast32_t nsamples, uint32_t random_seed, int nthreads);
+double hv_approx_normal_adaptive(double * std_error, uint_fast32_t * nsamples_used,
+                                 const double * data, int nobjs, int npoints,
+                                 const double * ref, const bool * maximise,
+                                 double rel_error, double z, uint_fast32_t max_nsamples,
+                                 uint32_t random_seed, int nthreads);
+void hvc_approx_hua_wang(double * hvc, const double * data, int nobjs, int npoints,
+                         const double * ref, const bool * maximise,
+                         uint_fast32_t nsamples, int nthreads);
+void hvc_approx_normal(double * hvc, const double * data, int nobjs, int npoints,
+                       const double * ref, const bool * maximise,
+                       uint_fast32_t nsamples, uint32_t random_seed, int nthreads);
+
+hvapprox_directions_t * hvapprox_directions_normal(int nobjs, uint_fast32_t nsamples,
+                                                   uint32_t random_seed, int nthreads);
+hvapprox_directions_t * hvapprox_directions_hua_wang(int nobjs, uint_fast32_t nsamples,
+                                                     int nthreads);
+void hvapprox_directions_free(hvapprox_directions_t * dirs);
+int hvapprox_directions_nobjs(const hvapprox_directions_t * dirs);
+uint_fast32_t hvapprox_directions_nsamples(const hvapprox_directions_t * dirs);
+int hvapprox_directions_save(const hvapprox_directions_t * dirs, const char * filename);
+hvapprox_directions_t * hvapprox_directions_load(const char * filename);
+double hv_approx_directions(const hvapprox_directions_t * dirs,
+                            const double * data, int nobjs, int npoints,
+                            const double * ref, const bool * maximise, int nthreads);
 #ifdef __cplusplus
 }
 #endif
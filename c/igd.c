@@ -97,119 +97,171 @@ OPTION_MAXIMISE_STR
 " -s, --suffix=STRING Create an output file for each input file by appending\n"
 "                     this suffix. This is ignored when reading from stdin. \n"
 "                     If missing, output is sent to stdout.                 \n"
+OPTION_JOBS_STR
 "\n");
 }
 
-static void
-do_file (const char *filename, double *reference, size_t reference_size,
-         int *nobj_p, const signed char * minmax, bool maximise_all_flag)
-{
-    double *data = NULL;
-    int *cumsizes = NULL;
-    int nruns = 0;
-    int nobj = *nobj_p;
-
-    handle_read_data_error(
-        read_double_data (filename, &data, &nobj, &cumsizes, &nruns), filename);
-    if (!filename)
-        filename = stdin_name;
-
-    char *outfilename = NULL;
-    FILE *outfile = stdout;
-    if (filename != stdin_name && suffix) {
-        outfilename = m_strcat(filename, suffix);
-        outfile = fopen (outfilename, "w");
-        if (outfile == NULL) {
-            errprintf ("%s: %s\n", outfilename, strerror(errno));
-            exit (EXIT_FAILURE);
-        }
-    }
-#if 0
-    if (union_flag) {
-        cumsizes[0] = cumsizes[nruns - 1];
-        nruns = 1;
-    }
-#endif
-    /* Default minmax if not set yet.  */
-    bool free_minmax = false;
-    if (minmax == NULL) {
-        minmax = maximise_all_flag ? minmax_maximise(nobj) : minmax_minimise(nobj);
-        free_minmax = true;
-    }
+enum { GD_value, IGD_value, GD_p_value, IGD_p_value, IGD_plus_value,
+       hausdorff_value, NVALUES };
 
-    const char * sep = "\0";
-    if (verbose_flag) {
-        printf("# file: %s\n", filename);
-        printf("# metrics (Euclidean distance) ");
-        /* This macro uses ## for comma elision in variadic macros. It should
-           use __VA_OPT__ in the future when more compilers support it:
-           https://gcc.gnu.org/onlinedocs/cpp/Variadic-Macros.html */
+/* The macros below use ## for comma elision in variadic macros. They should
+   use __VA_OPT__ in the future when more compilers support it:
+   https://gcc.gnu.org/onlinedocs/cpp/Variadic-Macros.html */
 #if defined(__clang__)
 #  pragma clang diagnostic push
 #  pragma clang diagnostic ignored "-Wgnu-zero-variadic-macro-arguments"
 #endif
+
+static void
+compute_values (double *value, const double *points_a, int size_a, int nobj,
+                const signed char * minmax, const double *reference,
+                size_t reference_size)
+{
+#define compute_value_if(IF, WHICH, FUN, ...)                                  \
+    do {                                                                       \
+        if (IF)                                                                \
+            value[WHICH] = FUN(nobj, minmax, points_a, size_a, reference, (int) reference_size, ## __VA_ARGS__); \
+    } while (0)
+
+    compute_value_if(gd, GD_value, GD_minmax);
+    compute_value_if(igd, IGD_value, IGD_minmax);
+    compute_value_if(gdp, GD_p_value, GD_p, exponent_p);
+    compute_value_if(igdp, IGD_p_value, IGD_p, exponent_p);
+    compute_value_if(igdplus, IGD_plus_value, IGD_plus_minmax);
+    compute_value_if(hausdorff, hausdorff_value, avg_Hausdorff_dist_minmax, exponent_p);
+#undef compute_value_if
+}
+
+static void
+print_header (FILE *outfile, const char *filename)
+{
+    if (!verbose_flag)
+        return;
+    const char * sep = "\0";
+    printf("# file: %s\n", filename);
+    printf("# metrics (Euclidean distance) ");
 #define print_value_if(IF, WHAT, ...)                                          \
-        do {                                                                   \
-            if (IF) {                                                          \
-                fprintf(outfile, "%s" WHAT, sep, ## __VA_ARGS__);              \
-                sep = "\t";                                                    \
-            }                                                                  \
-        } while (0)
-
-        print_value_if(gd, "GD");
-        print_value_if(igd, "IGD");
-        print_value_if(gdp, "GD_%d", exponent_p);
-        print_value_if(igdp,"IGD_%d", exponent_p);
-        print_value_if(igdplus, "IGD+");
-        print_value_if(hausdorff, "avg_Hausdorff");
+    do {                                                                       \
+        if (IF) {                                                              \
+            fprintf(outfile, "%s" WHAT, sep, ## __VA_ARGS__);                  \
+            sep = "\t";                                                        \
+        }                                                                      \
+    } while (0)
+
+    print_value_if(gd, "GD");
+    print_value_if(igd, "IGD");
+    print_value_if(gdp, "GD_%d", exponent_p);
+    print_value_if(igdp,"IGD_%d", exponent_p);
+    print_value_if(igdplus, "IGD+");
+    print_value_if(hausdorff, "avg_Hausdorff");
 #undef print_value_if
-        printf("\n");
-    }
+    printf("\n");
+}
 
-    for (int n = 0, cumsize = 0; n < nruns; cumsize = cumsizes[n], n++) {
-        _attr_maybe_unused double time_elapsed = 0;
-        int size_a = cumsizes[n] - cumsize;
-        const double *points_a = &data[nobj * cumsize];
-        //Timer_start ();
-        sep = "\0";
-
-#define print_value_if(IF, FUN, ...)                                           \
-        do {                                                                   \
-            if (IF) {                                                          \
-                fprintf (outfile, "%s" indicator_printf_format, sep,           \
-                         FUN(nobj, minmax, points_a, size_a, reference, (int) reference_size, ## __VA_ARGS__)); \
-                sep = "\t";                                                    \
-            }                                                                  \
-        } while (0)
-
-        print_value_if(gd, GD_minmax);
-        print_value_if(igd, IGD_minmax);
-        print_value_if(gdp, GD_p, exponent_p);
-        print_value_if(igdp, IGD_p, exponent_p);
-        print_value_if(igdplus, IGD_plus_minmax);
-        print_value_if(hausdorff, avg_Hausdorff_dist_minmax, exponent_p);
+static void
+print_values (outbuf_t *out, const double *value)
+{
+    const char * sep = "\0";
+#define print_value_if(IF, WHICH)                                              \
+    do {                                                                       \
+        if (IF) {                                                              \
+            outbuf_puts (out, sep);                                            \
+            outbuf_point (out, value[WHICH]);                                  \
+            sep = "\t";                                                        \
+        }                                                                      \
+    } while (0)
+
+    print_value_if(gd, GD_value);
+    print_value_if(igd, IGD_value);
+    print_value_if(gdp, GD_p_value);
+    print_value_if(igdp, IGD_p_value);
+    print_value_if(igdplus, IGD_plus_value);
+    print_value_if(hausdorff, hausdorff_value);
 #undef print_value_if
-#if defined(__clang__)
-#  pragma clang diagnostic pop
-#endif
-        //time_elapsed = Timer_elapsed_virtual ();
-        fprintf(outfile, "\n");
-        /* if (verbose_flag)  */
-        /*     fprintf (outfile, "# Time: %f seconds\n", time_elapsed); */
+    outbuf_putc(out, '\n');
+}
 
+/* Calculate and print the metrics of each set of FILENAME, reading one set
+   at a time.  The metrics are printed once the whole file has been read, so
+   that nothing is printed for a file with errors, as in do_files().  */
+static void
+do_file (const char *filename, const double *reference, size_t reference_size,
+         int *nobj_p, const signed char * minmax)
+{
+    dataset_reader_t *reader = open_dataset_reader(filename);
+    const double *points;
+    int size = 0;
+    read_next_set(reader, filename, &points, nobj_p, &size);
+    if (!filename)
+        filename = stdin_name;
+
+    vector_double values;
+    vector_double_ctor_zero(&values);
+    do {
+        double value[NVALUES];
+        compute_values(value, points, size, *nobj_p, minmax, reference, reference_size);
+        for (int i = 0; i < NVALUES; i++)
+            vector_double_push_back(&values, value[i]);
+    } while (read_next_set(reader, filename, &points, nobj_p, &size));
+    dataset_reader_close(reader);
+
+    char *outfilename;
+    FILE *outfile = open_output_file(filename, suffix, &outfilename);
+    print_header(outfile, filename);
+    outbuf_t *out = outbuf_new(outfile);
+    for (size_t n = 0; n < vector_double_size(&values); n += NVALUES)
+        print_values(out, vector_double_begin(&values) + n);
+    outbuf_free(out);
+    close_output_file(outfile, filename, outfilename, verbose_flag);
+    vector_double_dtor(&values);
+}
+
+/* Calculate and print the metrics of each set of NFILES input files read by
+   read_input_files(), computing the sets in parallel with up to NTHREADS
+   threads.  */
+static void
+do_files (input_file_t *files, int nfiles, const double *reference,
+          size_t reference_size, int nobj, const signed char * minmax,
+          int nthreads)
+{
+    int nsets;
+    int *set_file = input_files_sets(files, nfiles, &nsets);
+    double *values = malloc(sizeof(double) * NVALUES * MAX(nsets, 1));
+    if (nthreads < 1) nthreads = 1;
+#ifdef _OPENMP
+#pragma omp parallel for schedule(dynamic, 1) num_threads(nthreads) if (nthreads > 1 && nsets > 1)
+#endif
+    for (int t = 0; t < nsets; t++) {
+        const input_file_t *file = files + set_file[t];
+        const int n = t - file->first_set;
+        const int cumsize = (n == 0) ? 0 : file->cumsizes[n - 1];
+        compute_values(values + NVALUES * t, &file->data[nobj * cumsize],
+                       file->cumsizes[n] - cumsize, nobj, minmax, reference,
+                       reference_size);
     }
 
-    if (outfilename) {
-        if (verbose_flag)
-            fprintf (stderr, "# %s -> %s\n", filename, outfilename);
-        fclose (outfile);
-        free (outfilename);
+    for (int k = 0; k < nfiles; k++) {
+        const input_file_t *file = files + k;
+        const char *filename = file->filename;
+        handle_read_data_error(file->err, filename);
+        if (!filename)
+            filename = stdin_name;
+
+        char *outfilename;
+        FILE *outfile = open_output_file(filename, suffix, &outfilename);
+        print_header(outfile, filename);
+        outbuf_t *out = outbuf_new(outfile);
+        for (int n = 0; n < file->nruns; n++)
+            print_values(out, values + NVALUES * (file->first_set + n));
+        outbuf_free(out);
+        close_output_file(outfile, filename, outfilename, verbose_flag);
     }
-    free (data);
-    free (cumsizes);
-    if (free_minmax) free( (void *) minmax);
-    *nobj_p = nobj;
+    free (values);
+    free (set_file);
 }
+#if defined(__clang__)
+#  pragma clang diagnostic pop
+#endif
 
 int main(int argc, char *argv[])
 {
@@ -218,11 +270,12 @@ int main(int argc, char *argv[])
     const signed char *minmax = NULL;
     bool maximise_all_flag = false;
     int nobj = 0, tmp_nobj = 0;
+    int nthreads = 1;
 
     enum { GD_opt = 1000,
            IGD_opt, GD_p_opt, IGD_p_opt, IGD_plus_opt, hausdorff_opt};
     /* see the man page for getopt_long for an explanation of these fields */
-    static const char short_options[] = "hVvqap:Mr:s:o:";
+    static const char short_options[] = "hVvqap:Mr:s:o:j:";
     static const struct option long_options[] = {
         {"help",       no_argument,       NULL, 'h'},
         {"version",    no_argument,       NULL, 'V'},
@@ -241,6 +294,7 @@ int main(int argc, char *argv[])
         {"reference",  required_argument, NULL, 'r'},
         {"suffix",     required_argument, NULL, 's'},
         {"obj",        required_argument, NULL, 'o'},
+        {"jobs",       required_argument, NULL, 'j'},
         {NULL, 0, NULL, 0} /* marks end of list */
     };
     set_program_invocation_short_name(argv[0]);
@@ -314,6 +368,10 @@ int main(int argc, char *argv[])
             suffix = optarg;
             break;
 
+        case 'j': // --jobs
+            nthreads = parse_cmdline_jobs(optarg);
+            break;
+
         case 'q': // --quiet
             verbose_flag = false;
             break;
@@ -341,34 +399,30 @@ int main(int argc, char *argv[])
     reference_size = filter_dominated_set(reference, nobj, reference_size, minmax);
 
     int numfiles = argc - optind;
-    if (numfiles < 1) {/* Read stdin.  */
-        do_file (NULL, reference, reference_size, &nobj, minmax, maximise_all_flag);
-    } else if (numfiles == 1) {
-        do_file (argv[optind], reference, reference_size, &nobj, minmax, maximise_all_flag);
-    } else {
-        /* FIXME: Calculate the nondominated front among all input
-           files to use as reference set.  */
-#if 0
-        if (reference == NULL) {
-            reference_size =
-                calculate_nondominated (&reference, data, nobj, cumsizes[nruns-1],
-                                        minmax);
-            write_sets (stderr, reference, nobj, &reference_size, 1);
-        }
+    const char *stdin_file[] = { NULL };
+    const char **filenames = (numfiles < 1) /* Read stdin.  */
+        ? stdin_file : (const char **) argv + optind;
+    if (numfiles < 1)
+        numfiles = 1;
+
+    /* FIXME: Calculate the nondominated front among all input files to use
+       as reference set.  */
+    if (nthreads == 1) {
         for (int k = 0; k < numfiles; k++)
-            nondominatedfile_range (argv[optind + k], &maximum, &minimum, &nobj);
-
-        if (verbose_flag >= 2) {
-            printf ("# maximum:");
-            vector_printf (maximum, nobj);
-            printf ("\n");
-            printf ("# minimum:");
-            vector_printf (minimum, nobj);
-            printf ("\n");
+            do_file (filenames[k], reference, reference_size, &nobj, minmax);
+    } else {
+        /* Read just enough files at once to keep all threads busy.  */
+        const int batch = input_files_batch(numfiles, nthreads);
+        input_file_t *files = malloc(sizeof(input_file_t) * batch);
+        for (int start = 0; start < numfiles; start += batch) {
+            int nfiles = MIN(batch, numfiles - start);
+            for (int k = 0; k < nfiles; k++)
+                files[k] = (input_file_t) { .filename = filenames[start + k] };
+            read_input_files(files, nfiles, &nobj, false, nthreads);
+            do_files (files, nfiles, reference, reference_size, nobj, minmax, nthreads);
+            input_files_free(files, nfiles);
         }
-#endif
-        for (int k = 0; k < numfiles; k++)
-            do_file (argv[optind + k], reference, reference_size, &nobj, minmax, maximise_all_flag);
+        free(files);
     }
 
     free(reference);
@@ -14,179 +14,734 @@
 
  ----------------------------------------------------------------------
 
- TODO: things that may or may not improve reading performance.
-
-  * different values for PAGE_SIZE.
-
-  * reading whole lines and then sscanf the line.
-
-  * mmaping the input file (or a big chunk of few megabytes), then
-    read, then unmmap.
-
 *****************************************************************************/
 #include "config.h"
 #include <stdio.h>
 #include <stdlib.h>
-#include <ctype.h>
+#include <string.h>
 #include <limits.h>
+#include <stdint.h>
+#include <errno.h>
 #include "common.h"
 #include "io.h"
+#include "parse_double.h"
+#include "format_double.h"
+#ifdef HAVE_ZLIB
+#include <zlib.h>
+#endif
+#ifdef HAVE_LZMA
+#include <lzma.h>
+#endif
 
-/* FIXME: Do we need to handle the following weird files? */
-                /*
-                   fscanf (instream, "%*[ \t]");
-                   retval = fscanf (instream, "%1[\r\n]", newline);
-                   // We do not consider that '\r\n' starts a new set.
-                   if (retval == 1 && newline[0] == '\r')
-		    fscanf (instream, "%*[\n]");
-                */
-static inline int
-skip_trailing_whitespace(FILE * instream)
-{
-    int c;
-    do {
-        c = fgetc(instream);
-    } while (c == ' ' || c == '\t' || unlikely(c == '\r'));
-
-    if (c == '\n')
-        return 1;
-    if (unlikely(c == EOF))
-        return EOF;
-    ungetc(c, instream);  // Push the non-whitespace character back
+/* Input is read in blocks of at least this size.  */
+#ifndef IO_READ_BLOCK_SIZE
+#define IO_READ_BLOCK_SIZE (1024 * 1024)
+#endif
+/* When reading with several threads, each block is split into chunks of
+   about this size, with IO_PARALLEL_CHUNKS_PER_THREAD chunks per thread.  */
+#ifndef IO_PARALLEL_CHUNK_SIZE
+#define IO_PARALLEL_CHUNK_SIZE (1024 * 1024)
+#endif
+#define IO_PARALLEL_CHUNKS_PER_THREAD 4
+
+/* Compressed input is read in blocks of this size.  */
+#ifndef IO_COMPRESSED_BLOCK_SIZE
+#define IO_COMPRESSED_BLOCK_SIZE (256 * 1024)
+#endif
+
+/* An input stream, which is transparently decompressed if it starts with
+   the magic bytes of a compression format that we support.  */
+typedef enum {
+    INPUT_PLAIN, INPUT_GZIP, INPUT_XZ
+} input_format_t;
+
+typedef struct {
+    FILE * stream;
+    input_format_t format;
+    unsigned char * in; // Bytes read from STREAM and not consumed yet.
+    size_t in_pos;
+    size_t in_size;
+    bool in_eof;
+    bool end;           // End of the compressed data.
+    const char * error; // Error found while decompressing.
+#ifdef HAVE_ZLIB
+    z_stream gz;
+#endif
+#ifdef HAVE_LZMA
+    lzma_stream xz;
+#endif
+} input_source_t;
+
+static bool
+input_source_refill(input_source_t * s)
+{
+    if (s->in_eof)
+        return false;
+    s->in_pos = 0;
+    s->in_size = fread(s->in, 1, IO_COMPRESSED_BLOCK_SIZE, s->stream);
+    if (s->in_size < IO_COMPRESSED_BLOCK_SIZE)
+        s->in_eof = true;
+    return s->in_size > 0;
+}
+
+static inline bool
+input_source_has_magic(const input_source_t * s, const char * magic, size_t len)
+{
+    return s->in_size >= len && memcmp(s->in, magic, len) == 0;
+}
+
+/* Open FILENAME, or stdin if *FILENAME_P is NULL, and detect whether it is
+   compressed.  Returns 0 or an error code of read_objective_t_data().  */
+static int
+input_source_open(input_source_t * s, const char ** filename_p)
+{
+    const char * filename = *filename_p;
+    memset(s, 0, sizeof(*s));
+    if (filename == NULL) {
+        s->stream = stdin;
+        *filename_p = stdin_name; /* used to diagnose errors.  */
+    } else if (unlikely(NULL == (s->stream = fopen (filename,"rb")))) {
+        errprintf ("%s: %s", filename, strerror (errno));
+        return ERROR_FOPEN;
+    }
+    filename = *filename_p;
+    s->in = malloc(IO_COMPRESSED_BLOCK_SIZE);
+    input_source_refill(s);
+
+    const char * unsupported = NULL;
+    if (input_source_has_magic(s, "\x1f\x8b", 2)) {
+#ifdef HAVE_ZLIB
+        s->format = INPUT_GZIP;
+        // 15 + 16: only gzip, with the largest window.
+        if (inflateInit2(&s->gz, 15 + 16) != Z_OK) {
+            errprintf ("%s: cannot initialize gzip decompression", filename);
+            return ERROR_FOPEN;
+        }
+        s->gz.next_in = s->in;
+        s->gz.avail_in = (uInt) s->in_size;
+#else
+        unsupported = "gzip";
+#endif
+    } else if (input_source_has_magic(s, "\xfd" "7zXZ\0", 6)) {
+#ifdef HAVE_LZMA
+        s->format = INPUT_XZ;
+        const lzma_stream init = LZMA_STREAM_INIT;
+        s->xz = init;
+        if (lzma_stream_decoder(&s->xz, UINT64_MAX, LZMA_CONCATENATED) != LZMA_OK) {
+            errprintf ("%s: cannot initialize xz decompression", filename);
+            return ERROR_FOPEN;
+        }
+        s->xz.next_in = s->in;
+        s->xz.avail_in = s->in_size;
+#else
+        unsupported = "xz";
+#endif
+    } else if (input_source_has_magic(s, "\x28\xb5\x2f\xfd", 4)) {
+        unsupported = "zstd";
+    } else if (input_source_has_magic(s, "BZh", 3)) {
+        unsupported = "bzip2";
+    }
+    if (unsupported) {
+        errprintf ("%s: reading %s-compressed input is not supported", filename, unsupported);
+        return ERROR_FOPEN;
+    }
     return 0;
 }
 
-/* skip full lines starting with # */
-static inline int
-skip_comment_line(FILE *instream)
+static void
+input_source_close(input_source_t * s)
 {
-    int c = skip_trailing_whitespace(instream);
-    if (c == 1)
-        return 1;
-    if (unlikely(c == EOF))
-        return EOF;
+#ifdef HAVE_ZLIB
+    if (s->format == INPUT_GZIP)
+        inflateEnd(&s->gz);
+#endif
+#ifdef HAVE_LZMA
+    if (s->format == INPUT_XZ)
+        lzma_end(&s->xz);
+#endif
+    free(s->in);
+    s->in = NULL;
+    if (s->stream != NULL && s->stream != stdin)
+        fclose(s->stream);
+    s->stream = NULL;
+}
 
-    c = fgetc(instream);
-    if (unlikely(c == '#')) {
-        do { // Skip the rest of the line
-            c = fgetc(instream);
-            if (c == '\n')
-                return 1;
-            if (unlikely(c == EOF))
-                return EOF;
-        } while (true);
+#ifdef HAVE_ZLIB
+static size_t
+gzip_read(input_source_t * s, unsigned char * dst, size_t n)
+{
+    z_stream * z = &s->gz;
+    size_t done = 0;
+    while (done < n && !s->end && !s->error) {
+        if (z->avail_in == 0) {
+            if (!input_source_refill(s)) {
+                s->error = "unexpected end of gzip data";
+                break;
+            }
+            z->next_in = s->in;
+            z->avail_in = (uInt) s->in_size;
+        }
+        const size_t want = MIN(n - done, (size_t) UINT_MAX);
+        z->next_out = dst + done;
+        z->avail_out = (uInt) want;
+        int ret = inflate(z, Z_NO_FLUSH);
+        done += want - z->avail_out;
+        if (ret == Z_STREAM_END) {
+            // Several gzip members may be concatenated.
+            if (z->avail_in == 0 && input_source_refill(s)) {
+                z->next_in = s->in;
+                z->avail_in = (uInt) s->in_size;
+            }
+            if (z->avail_in == 0)
+                s->end = true;
+            else
+                inflateReset(z);
+        } else if (ret != Z_OK && ret != Z_BUF_ERROR) {
+            s->error = (z->msg != NULL) ? z->msg : "invalid gzip data";
+        }
     }
+    return done;
+}
+#endif
 
-    if (c == '\n')
-        return 1;
-    if (unlikely(c == EOF))
-        return EOF;
+#ifdef HAVE_LZMA
+static size_t
+xz_read(input_source_t * s, unsigned char * dst, size_t n)
+{
+    lzma_stream * z = &s->xz;
+    z->next_out = dst;
+    z->avail_out = n;
+    while (z->avail_out > 0 && !s->end && !s->error) {
+        if (z->avail_in == 0 && input_source_refill(s)) {
+            z->next_in = s->in;
+            z->avail_in = s->in_size;
+        }
+        lzma_ret ret = lzma_code(z, (z->avail_in == 0 && s->in_eof) ? LZMA_FINISH : LZMA_RUN);
+        if (ret == LZMA_STREAM_END)
+            s->end = true;
+        else if (ret == LZMA_BUF_ERROR)
+            s->error = "unexpected end of xz data";
+        else if (ret != LZMA_OK)
+            s->error = (ret == LZMA_MEM_ERROR) ? "out of memory" : "invalid xz data";
+    }
+    return n - z->avail_out;
+}
+#endif
 
-    ungetc(c, instream);  // Not a comment, push back
-    return 0;
+/* Read up to N bytes of (decompressed) input into DST.  Returns fewer than N
+   bytes only at the end of the input or after an error.  */
+static size_t
+input_source_read(input_source_t * s, void * dst, size_t n)
+{
+    switch (s->format) {
+#ifdef HAVE_ZLIB
+      case INPUT_GZIP:
+          return gzip_read(s, dst, n);
+#endif
+#ifdef HAVE_LZMA
+      case INPUT_XZ:
+          return xz_read(s, dst, n);
+#endif
+      default:
+          break;
+    }
+    const size_t k = MIN(s->in_size - s->in_pos, n);
+    memcpy(dst, s->in + s->in_pos, k);
+    s->in_pos += k;
+    if (k == n || s->in_eof)
+        return k;
+    return k + fread((char *) dst + k, 1, n - k, s->stream);
 }
 
-int
-fread_double(FILE *instream, double *number)
+/* Returns true, after reporting it, if there was an error while
+   decompressing the input.  */
+static bool
+input_source_failed(const input_source_t * s, const char * filename)
 {
-    int c;
-    // Skip leading whitespace.
-    do {
-        c = fgetc(instream);
-    } while (c == ' ' || c == '\t' || c == '\r');
+    if (likely(s->error == NULL))
+        return false;
+    errprintf ("%s: %s", filename, s->error);
+    return true;
+}
 
-    if (unlikely(c == EOF))
-        return EOF;
+/* Reads a stream in large blocks and hands out the complete lines read so
+   far, so that they can be parsed with plain pointers.  An incomplete line at
+   the end of a block is kept for the next block, and the buffer grows if a
+   single line does not fit.  The next block may be read ahead into a spare
+   buffer by block_reader_prefetch() while the current one is parsed.  */
+typedef struct {
+    input_source_t * source;
+    char * buf;
+    size_t capacity;
+    size_t size; // Bytes in buf.
+    size_t pos;  // Bytes of buf already handed out.
+    char * spare; // Bytes read ahead.
+    size_t spare_pos;
+    size_t spare_size;
+    size_t spare_capacity;
+    bool source_eof;
+    bool eof;
+} block_reader_t;
 
-    char buffer[128];
-    size_t i = 0;
-    do {
-        buffer[i] = (char) c;
-        i++;
-        c = fgetc(instream);
-        if (isspace(c) || unlikely(c == EOF))
+static void
+block_reader_init(block_reader_t * r, input_source_t * source, size_t capacity)
+{
+    r->source = source;
+    r->capacity = capacity;
+    r->buf = malloc(r->capacity);
+    r->size = r->pos = 0;
+    r->spare = NULL;
+    r->spare_pos = r->spare_size = r->spare_capacity = 0;
+    r->source_eof = r->eof = false;
+}
+
+static void
+block_reader_free(block_reader_t * r)
+{
+    free(r->buf);
+    free(r->spare);
+    r->buf = r->spare = NULL;
+}
+
+/* Read the next N bytes of the input into DST, first from the bytes read
+   ahead.  Returns fewer than N bytes only at the end of the input.  */
+static size_t
+block_reader_fill(block_reader_t * r, void * dst, size_t n)
+{
+    const size_t k = MIN(r->spare_size - r->spare_pos, n);
+    if (k > 0) // SPARE is NULL until the first prefetch.
+        memcpy(dst, r->spare + r->spare_pos, k);
+    r->spare_pos += k;
+    if (k == n || r->source_eof)
+        return k;
+    const size_t m = input_source_read(r->source, (char *) dst + k, n - k);
+    if (m < n - k)
+        r->source_eof = true;
+    return k + m;
+}
+
+/* Read the next block of the input into the spare buffer, if it is empty.
+   It does not touch the current block, thus it may run concurrently with
+   parsing it.  */
+static void
+block_reader_prefetch(block_reader_t * r)
+{
+    if (r->spare_pos < r->spare_size || r->source_eof)
+        return;
+    if (r->spare == NULL) {
+        r->spare_capacity = r->capacity;
+        r->spare = malloc(r->spare_capacity);
+    }
+    r->spare_pos = 0;
+    r->spare_size = input_source_read(r->source, r->spare, r->spare_capacity);
+    if (r->spare_size < r->spare_capacity)
+        r->source_eof = true;
+}
+
+/* Returns a pointer to the next block of complete lines and sets *END_P to
+   its end, or NULL at the end of the stream.  The last line of the stream
+   may not end with a newline.  The block is valid until the next call.  */
+static const char *
+block_reader_next(block_reader_t * r, const char ** end_p)
+{
+    // Move the incomplete last line to the front.
+    const size_t rest = r->size - r->pos;
+    if (rest > 0 && r->pos > 0)
+        memmove(r->buf, r->buf + r->pos, rest);
+    r->size = rest;
+    r->pos = 0;
+    size_t scanned = 0; // Bytes known not to contain a newline.
+    while (true) {
+        // Look for the last newline in the data not scanned yet.
+        size_t i = r->size;
+        while (i > scanned && r->buf[i - 1] != '\n')
+            i--;
+        if (i > scanned) {
+            r->pos = i;
+            *end_p = r->buf + i;
+            return r->buf;
+        }
+        scanned = r->size;
+        if (r->eof)
             break;
-        if (unlikely(i == sizeof(buffer) - 1))
-            return 0; // Number is too long.
-    } while (true);
+        if (r->size == r->capacity) {
+            r->capacity *= 2;
+            r->buf = realloc(r->buf, r->capacity);
+        }
+        const size_t want = r->capacity - r->size;
+        const size_t n = block_reader_fill(r, r->buf + r->size, want);
+        r->size += n;
+        // A short read means end of file or error, in which case we stop
+        // reading like fgetc() does.
+        if (n < want)
+            r->eof = true;
+    }
+    if (r->size == 0)
+        return NULL;
+    r->pos = r->size;
+    *end_p = r->buf + r->size;
+    return r->buf;
+}
 
-    if (c == '\n')
-        ungetc(c, instream);  // Push back newlines
+/* Buffer at least N bytes, if the stream is long enough, without consuming
+   them.  Returns the number of bytes buffered.  */
+static size_t
+block_reader_peek(block_reader_t * r, size_t n)
+{
+    assert(r->pos == 0 && n <= r->capacity);
+    while (r->size < n && !r->eof) {
+        const size_t want = r->capacity - r->size;
+        const size_t k = block_reader_fill(r, r->buf + r->size, want);
+        r->size += k;
+        if (k < want)
+            r->eof = true;
+    }
+    return r->size;
+}
 
-    buffer[i] = '\0';
-    char *endptr;
-    *number = strtod(buffer, &endptr);
-    if (unlikely(endptr == buffer))
-        return 0; // Invalid conversion
+/* Copy the next N bytes of the stream to DST.  Returns false if the stream
+   ends before.  */
+static bool
+block_reader_read(block_reader_t * r, void * dst, size_t n)
+{
+    const size_t k = MIN(r->size - r->pos, n);
+    memcpy(dst, r->buf + r->pos, k);
+    r->pos += k;
+    if (k == n)
+        return true;
+    return !r->eof && block_reader_fill(r, (char *) dst + k, n - k) == n - k;
+}
+
+static const char binary_magic[8] = { 'M','O','O','D','A','T','A','1' };
 
-    return 1; // Success !
+static bool
+block_reader_is_binary(block_reader_t * r)
+{
+    return block_reader_peek(r, sizeof(binary_magic)) >= sizeof(binary_magic)
+        && memcmp(r->buf, binary_magic, sizeof(binary_magic)) == 0;
 }
 
-int
-fread_int(FILE *instream, int *number)
+typedef struct {
+    uint32_t dtype;
+    uint32_t nobjs;
+    uint32_t nsets;
+    uint64_t npoints;
+} binary_header_t;
+
+/* Offset of the values from the start of a binary file with NSETS sets.  */
+static inline size_t
+binary_data_offset(size_t nsets)
 {
-    int c;
-    // Skip leading whitespace.
-    do {
-        c = fgetc(instream);
-    } while (c == ' ' || c == '\t' || c == '\r');
+    const size_t size = BINARY_HEADER_SIZE + nsets * sizeof(int32_t);
+    return (size + BINARY_DATA_ALIGNMENT - 1) / BINARY_DATA_ALIGNMENT * BINARY_DATA_ALIGNMENT;
+}
 
-    if (c == EOF)
-        return EOF;
+static bool
+read_binary_header(block_reader_t * r, const char * filename, binary_header_t * h)
+{
+    char magic[sizeof(binary_magic)];
+    uint32_t bom;
+    if (!block_reader_read(r, magic, sizeof(magic))
+        || !block_reader_read(r, &bom, sizeof(bom))
+        || !block_reader_read(r, &h->dtype, sizeof(h->dtype))
+        || !block_reader_read(r, &h->nobjs, sizeof(h->nobjs))
+        || !block_reader_read(r, &h->nsets, sizeof(h->nsets))
+        || !block_reader_read(r, &h->npoints, sizeof(h->npoints))) {
+        errprintf ("%s: truncated binary data", filename);
+        return false;
+    }
+    if (bom != BINARY_BYTE_ORDER_MARK) {
+        errprintf ("%s: binary data was written with a different byte order", filename);
+        return false;
+    }
+    if (h->nobjs == 0 || h->nobjs > INT_MAX || h->nsets > INT_MAX || h->npoints > INT_MAX
+        || (h->npoints == 0) != (h->nsets == 0)) {
+        errprintf ("%s: invalid binary data header", filename);
+        return false;
+    }
+    return true;
+}
 
+/* Read the cumulative sizes of a binary file and the padding up to the
+   values.  */
+static bool
+read_binary_cumsizes(block_reader_t * r, const char * filename, const binary_header_t * h,
+                     int * cumsizes, int offset)
+{
+    if (!block_reader_read(r, cumsizes, h->nsets * sizeof(int32_t))) {
+        errprintf ("%s: truncated binary data", filename);
+        return false;
+    }
+    int prev = 0;
+    for (uint32_t k = 0; k < h->nsets; k++) {
+        if (cumsizes[k] <= prev || (uint64_t) cumsizes[k] > h->npoints) {
+            errprintf ("%s: invalid size of set %u in binary data", filename, (unsigned) k + 1);
+            return false;
+        }
+        prev = cumsizes[k];
+        cumsizes[k] += offset;
+    }
+    if ((uint64_t) prev != h->npoints) {
+        errprintf ("%s: invalid binary data header", filename);
+        return false;
+    }
+    char padding[BINARY_DATA_ALIGNMENT];
+    const size_t npad = binary_data_offset(h->nsets) - BINARY_HEADER_SIZE
+        - h->nsets * sizeof(int32_t);
+    if (!block_reader_read(r, padding, npad)) {
+        errprintf ("%s: truncated binary data", filename);
+        return false;
+    }
+    return true;
+}
+
+/* Whitespace that separates values within a line.  */
+static inline bool
+is_separator(char c)
+{
+    return c == ' ' || c == '\t' || unlikely(c == '\r' || c == '\v' || c == '\f');
+}
+
+static inline const char *
+skip_separators(const char * p, const char * end)
+{
+    while (p < end && is_separator(*p))
+        p++;
+    return p;
+}
+
+/* Returns a pointer to the first character of the next line.  */
+static inline const char *
+skip_line(const char * p, const char * end)
+{
+    const char * nl = memchr(p, '\n', (size_t) (end - p));
+    return (nl == NULL) ? end : nl + 1;
+}
+
+static inline const char *
+token_end(const char * p, const char * end)
+{
+    while (p < end && *p != '\n' && !is_separator(*p))
+        p++;
+    return p;
+}
+
+/* Copy the token that starts at P to BUFFER as a NUL-terminated string.
+   Returns the end of the token or NULL if it does not fit.  */
+static inline const char *
+copy_token(char * buffer, size_t size, const char * p, const char * end)
+{
+    const char * tend = token_end(p, end);
+    const size_t len = (size_t) (tend - p);
+    if (unlikely(len >= size))
+        return NULL; // Number is too long.
+    memcpy(buffer, p, len);
+    buffer[len] = '\0';
+    return tend;
+}
+
+static void
+report_conversion_error(const char * filename, int line, int column,
+                        const char * p, const char * end, const char * type_str)
+{
     char buffer[64];
-    size_t i = 0;
-    do {
-        buffer[i] = (char) c;
-        i++;
-        c = fgetc(instream);
-        if (isspace(c) || c == EOF)
-            break;
-        if (i == sizeof(buffer) - 1)
-            return 0; // Number is too long.
-    } while (true);
+    size_t len = (size_t) (token_end(p, end) - p);
+    len = MIN(len, (size_t) 60);
+    memcpy(buffer, p, len);
+    buffer[len] = '\0';
+    errprintf ("%s: line %d column %d: "
+               "could not convert string `%s' to %s",
+               filename, line, column, buffer, type_str);
+}
+
+static void
+report_columns_error(int error, const char * filename, int line, int column, int nobjs)
+{
+    if (error == READ_INPUT_WRONG_INITIAL_DIM)
+        errprintf ("%s: line %d: input has dimension %d"
+                   " while previous data has dimension %d",
+                   filename,line, column, nobjs);
+    else
+        errprintf ("%s: line %d has different number of columns (%d)"
+                   " from first row (%d)\n",
+                   filename, line, column, nobjs);
+}
 
-    if (c == '\n')
-        ungetc(c, instream);  // Push back newlines.
+/* A chunk of complete lines parsed by one thread.  Consecutive rows that
+   are not separated by empty lines form a run.  The runs of consecutive
+   chunks are joined into sets after parsing.  */
+typedef struct {
+    const char * begin, * end;
+    int line0;            // Lines before the chunk.
+    int nlines;
+    size_t nvalues;       // Values in all rows of the chunk.
+    size_t offset;        // Position of the first value in data.
+    int * runs;           // Rows in each run.
+    size_t nruns, runs_capacity;
+    bool break_first;     // There is an empty line before the first row.
+    bool break_last;      // There is an empty line after the last row.
+    int error;            // First error found, if any.
+    int error_line, error_column;
+    const char * error_pos;
+} text_chunk_t;
+
+/* Split [BEGIN, END) into at most NCHUNKS chunks of complete lines.  Returns
+   the number of chunks.  */
+static int
+split_text_chunks(text_chunk_t * chunks, int nchunks, const char * begin, const char * end)
+{
+    const size_t size = (size_t) (end - begin);
+    const char * p = begin;
+    int c = 0;
+    while (p < end && c < nchunks) {
+        const char * target = begin + (size_t) (c + 1) * (size / (size_t) nchunks);
+        const char * q = (c == nchunks - 1 || target >= end)
+            ? end : skip_line(MAX(target, p), end);
+        chunks[c].begin = p;
+        chunks[c].end = q;
+        p = q;
+        c++;
+    }
+    return c;
+}
 
-    buffer[i] = '\0';
+/* First pass: count the lines and the values of a chunk.  */
+static void
+count_text_chunk(text_chunk_t * c)
+{
+    const char * p = c->begin, * end = c->end;
+    int nlines = 0;
+    size_t nvalues = 0;
+    while (p < end) {
+        nlines++;
+        p = skip_separators(p, end);
+        if (p == end || *p == '\n' || unlikely(*p == '#')) {
+            p = skip_line(p, end);
+            continue;
+        }
+        do {
+            nvalues++;
+            p = skip_separators(token_end(p, end), end);
+        } while (p < end && *p != '\n');
+        if (p < end)
+            p++; /* skip newline */
+    }
+    c->nlines = nlines;
+    c->nvalues = nvalues;
+}
 
+static void
+text_chunk_new_run(text_chunk_t * c)
+{
+    if (c->nruns == c->runs_capacity) {
+        c->runs_capacity = MAX((size_t) 16, 2 * c->runs_capacity);
+        c->runs = realloc(c->runs, c->runs_capacity * sizeof(int));
+    }
+    c->runs[c->nruns++] = 0;
+}
+
+/* Number of columns of the first row in [P, END) or 0 if there is none.  */
+static int
+first_row_ncolumns(const char * p, const char * end)
+{
+    while (p < end) {
+        p = skip_separators(p, end);
+        if (p == end || *p == '\n' || unlikely(*p == '#')) {
+            p = skip_line(p, end);
+            continue;
+        }
+        int column = 0;
+        do {
+            column++;
+            p = skip_separators(token_end(p, end), end);
+        } while (p < end && *p != '\n');
+        return column;
+    }
+    return 0;
+}
+
+/* Parse the number that starts at P.  Returns a pointer to the end of the
+   token or NULL if it is not a valid number.  */
+static const char *
+parse_double_token(const char * p, const char * end, double * number)
+{
+    const char * q = parse_double(p, end, number);
+    if (likely(q != NULL && (q == end || *q == '\n' || is_separator(*q))))
+        return q;
+
+    // Anything else is converted by strtod().
+    char buffer[128];
+    const char * tend = copy_token(buffer, sizeof(buffer), p, end);
+    if (unlikely(tend == NULL))
+        return NULL;
+    char *endptr;
+    *number = strtod(buffer, &endptr);
+    if (unlikely(endptr == buffer))
+        return NULL; // Invalid conversion
+    return tend;
+}
+
+static const char *
+parse_int_token(const char * p, const char * end, int * number)
+{
+    char buffer[64];
+    const char * tend = copy_token(buffer, sizeof(buffer), p, end);
+    if (unlikely(tend == NULL))
+        return NULL;
     char *endptr;
     long value = strtol(buffer, &endptr, /*base=*/10);
     if (endptr == buffer)
-        return 0; // Invalid conversion.
+        return NULL; // Invalid conversion.
 
     if (value < INT_MIN || value > INT_MAX)
-        return 0;  // Out of range.
+        return NULL;  // Out of range.
 
     *number = (int) value;
-    return 1; // Success !
+    return tend;
 }
 
 #define objective_t int
-#define fread_objective_t fread_int
+#define objective_t_dtype BINARY_DTYPE_INT
+#define read_objective_t_binary read_int_binary
+#define parse_objective_t parse_int_token
+#define parse_chunk_objective_t parse_chunk_int
 #define read_objective_t_data read_int_data
+#define read_objective_t_data_parallel read_int_data_parallel
 #include "io_priv.h"
 #undef objective_t
-#undef fread_objective_t
+#undef objective_t_dtype
+#undef read_objective_t_binary
+#undef parse_objective_t
+#undef parse_chunk_objective_t
 #undef read_objective_t_data
+#undef read_objective_t_data_parallel
 
 #define objective_t double
-#define fread_objective_t fread_double
+#define objective_t_dtype BINARY_DTYPE_DOUBLE
+#define read_objective_t_binary read_double_binary
+#define parse_objective_t parse_double_token
+#define parse_chunk_objective_t parse_chunk_double
 #define read_objective_t_data read_double_data
+#define read_objective_t_data_parallel read_double_data_parallel
 #include "io_priv.h"
 #undef objective_t
-#undef fread_objective_t
+#undef objective_t_dtype
+#undef read_objective_t_binary
+#undef parse_objective_t
+#undef parse_chunk_objective_t
 #undef read_objective_t_data
+#undef read_objective_t_data_parallel
 
-/* Convenience wrapper to read_double_data used by Python's moocore.  */
+/* Convenience wrapper to read_double_data_parallel used by Python's moocore.  */
 int
-read_datasets(const char * filename, double **data_p, int *ncols_p, int *datasize_p)
+read_datasets(const char * filename, double **data_p, int *ncols_p, int *datasize_p,
+              int nthreads)
 {
     double * data = NULL;
     int * cumsizes = NULL;
     int nsets = 0, nobjs = 0;
-    int error = read_double_data(filename, &data, &nobjs, &cumsizes, &nsets);
+    int error = read_double_data_parallel(filename, &data, &nobjs, &cumsizes, &nsets,
+                                          nthreads);
     if (unlikely(error))
         return error;
 
@@ -214,14 +769,263 @@ read_datasets(const char * filename, double **data_p, int *ncols_p, int *datasiz
     return 0;
 }
 
+struct dataset_reader {
+    input_source_t source;
+    block_reader_t reader;
+    const char * filename;
+    const char * p, * end; // Lines of the current block not parsed yet.
+    int line;
+    bool binary;
+    int nsets; // Sets returned so far.
+    int * cumsizes; // Cumulative sizes of a binary file.
+    binary_header_t header;
+    double * data; // Points of the current set.
+    size_t datasize;
+};
+
+int
+dataset_reader_open(dataset_reader_t **reader_p, const char *filename)
+{
+    *reader_p = NULL;
+    dataset_reader_t * r = malloc(sizeof(dataset_reader_t));
+    int errorcode = input_source_open(&r->source, &filename);
+    if (unlikely(errorcode)) {
+        input_source_close(&r->source);
+        free(r);
+        return errorcode;
+    }
+    r->filename = filename;
+    r->p = r->end = NULL;
+    r->line = 0;
+    r->nsets = 0;
+    r->cumsizes = NULL;
+    r->data = NULL;
+    r->datasize = 0;
+    block_reader_init(&r->reader, &r->source, IO_READ_BLOCK_SIZE);
+    r->binary = block_reader_is_binary(&r->reader);
+    if (r->binary) {
+        binary_header_t * h = &r->header;
+        if (!read_binary_header(&r->reader, filename, h))
+            errorcode = ERROR_CONVERSION;
+        else if (h->dtype != BINARY_DTYPE_DOUBLE) {
+            errprintf ("%s: binary data does not contain values of type double",
+                       filename);
+            errorcode = ERROR_CONVERSION;
+        } else {
+            r->cumsizes = malloc(sizeof(int) * MAX(h->nsets, 1U));
+            if (!read_binary_cumsizes(&r->reader, filename, h, r->cumsizes, 0))
+                errorcode = ERROR_CONVERSION;
+        }
+        if (unlikely(errorcode)) {
+            dataset_reader_close(r);
+            return errorcode;
+        }
+    }
+    *reader_p = r;
+    return 0;
+}
+
+static int
+dataset_reader_next_binary(dataset_reader_t *r, int *nobjs_p, int *size_p)
+{
+    const binary_header_t * h = &r->header;
+    if (h->npoints == 0)
+        return READ_INPUT_FILE_EMPTY;
+    if (r->nsets == (int) h->nsets)
+        return 0;
+    const int nobjs = *nobjs_p;
+    if (nobjs != 0 && (int) h->nobjs != nobjs) {
+        errprintf ("%s: input has dimension %d while previous data has dimension %d",
+                   r->filename, (int) h->nobjs, nobjs);
+        return READ_INPUT_WRONG_INITIAL_DIM;
+    }
+    const int first = (r->nsets == 0) ? 0 : r->cumsizes[r->nsets - 1];
+    const int size = r->cumsizes[r->nsets] - first;
+    const size_t nvalues = (size_t) size * h->nobjs;
+    if (nvalues > r->datasize) {
+        r->datasize = nvalues;
+        r->data = realloc(r->data, r->datasize * sizeof(double));
+    }
+    if (!block_reader_read(&r->reader, r->data, nvalues * sizeof(double))) {
+        errprintf ("%s: truncated binary data", r->filename);
+        return ERROR_CONVERSION;
+    }
+    r->nsets++;
+    *nobjs_p = (int) h->nobjs;
+    *size_p = size;
+    return 1;
+}
+
+/* Same parser as read_double_data(), but it stops after each set.  */
+static int
+dataset_reader_next_text(dataset_reader_t *r, int *nobjs_p, int *size_p)
+{
+    int nobjs = *nobjs_p;
+    size_t ntotal = 0;
+    int size = 0;
+    const char *p = r->p, *end = r->end;
+    while (true) {
+        if (p == end) {
+            p = block_reader_next(&r->reader, &end);
+            if (p == NULL) {
+                p = end = NULL;
+                break;
+            }
+        }
+        r->line++;
+        p = skip_separators(p, end);
+        /* Empty lines and lines starting with # separate data sets.  */
+        if (p == end || *p == '\n' || unlikely(*p == '#')) {
+            p = skip_line(p, end);
+            if (size > 0)
+                break;
+            continue;
+        }
+        int column = 0;
+        do {
+            column++;
+            if (ntotal == r->datasize) {
+                r->datasize = MAX(2 * r->datasize, (size_t) 1024);
+                r->data = realloc(r->data, r->datasize * sizeof(double));
+            }
+            const char * next = parse_double_token(p, end, r->data + ntotal);
+            if (unlikely(next == NULL)) {
+                report_conversion_error(r->filename, r->line, column, p, end, "double");
+                return ERROR_CONVERSION;
+            }
+            ntotal++;
+            p = skip_separators(next, end);
+        } while (p < end && *p != '\n');
+        if (p < end)
+            p++; /* skip newline */
+
+        if (!nobjs)
+            nobjs = column;
+        else if (unlikely(column != nobjs)) {
+            /* just finished first row?  */
+            int errorcode = (r->nsets == 0 && size == 0)
+                ? READ_INPUT_WRONG_INITIAL_DIM : ERROR_COLUMNS;
+            report_columns_error(errorcode, r->filename, r->line, column, nobjs);
+            return errorcode;
+        }
+        size++;
+    }
+    r->p = p;
+    r->end = end;
+    if (size == 0)
+        return (r->nsets == 0) ? READ_INPUT_FILE_EMPTY : 0;
+    r->nsets++;
+    *nobjs_p = nobjs;
+    *size_p = size;
+    return 1;
+}
+
+int
+dataset_reader_next_set(dataset_reader_t *reader, const double **data_p,
+                        int *nobjs_p, int *size_p)
+{
+    int result = reader->binary
+        ? dataset_reader_next_binary(reader, nobjs_p, size_p)
+        : dataset_reader_next_text(reader, nobjs_p, size_p);
+    /* An error while decompressing may look like a different error.  */
+    if (unlikely(result <= 0 && input_source_failed(&reader->source, reader->filename)))
+        result = ERROR_CONVERSION;
+    *data_p = reader->data;
+    return result;
+}
+
+void
+dataset_reader_close(dataset_reader_t *reader)
+{
+    block_reader_free(&reader->reader);
+    input_source_close(&reader->source);
+    free(reader->cumsizes);
+    free(reader->data);
+    free(reader);
+}
+
+outbuf_t *
+outbuf_new (FILE *stream)
+{
+    outbuf_t * out = malloc(sizeof(outbuf_t));
+    out->stream = stream;
+    out->size = 0;
+    return out;
+}
+
+void
+outbuf_flush (outbuf_t *out)
+{
+    if (out->size > 0)
+        fwrite(out->buf, 1, out->size, out->stream);
+    out->size = 0;
+}
+
+void
+outbuf_free (outbuf_t *out)
+{
+    if (out == NULL)
+        return;
+    outbuf_flush(out);
+    free(out);
+}
+
+void
+outbuf_double (outbuf_t *out, double x)
+{
+    outbuf_reserve(out, FORMAT_DOUBLE_MAXLEN);
+    char * end = format_double(out->buf + out->size, x);
+    out->size = (size_t) (end - out->buf);
+}
+
+/* Same as point_printf_format, that is, padded with spaces up to
+   point_printf_width characters.  */
+void
+outbuf_point (outbuf_t *out, double x)
+{
+    outbuf_reserve(out, OUTBUF_ITEM_MAXLEN);
+    char * start = out->buf + out->size;
+    char * end = format_double(start, x);
+    while (end - start < point_printf_width)
+        *end++ = ' ';
+    out->size = (size_t) (end - out->buf);
+}
+
+void
+outbuf_vector (outbuf_t *out, const double *vector, int size)
+{
+    ASSUME(size > 0);
+    outbuf_point (out, vector[0]);
+    for (int k = 1; k < size; k++) {
+        outbuf_puts (out, point_printf_sep);
+        outbuf_point (out, vector[k]);
+    }
+}
+
+void
+outbuf_int (outbuf_t *out, int x)
+{
+    outbuf_reserve(out, 12);
+    char tmp[12];
+    unsigned u = (x < 0) ? 0U - (unsigned) x : (unsigned) x;
+    int n = 0;
+    do {
+        tmp[n++] = (char) ('0' + u % 10);
+        u /= 10;
+    } while (u > 0);
+    if (x < 0)
+        out->buf[out->size++] = '-';
+    while (n > 0)
+        out->buf[out->size++] = tmp[--n];
+}
+
 #ifndef R_PACKAGE
 void
 vector_fprintf (FILE *stream, const double * vector, int size)
 {
-    ASSUME(size > 0);
-    fprintf (stream, point_printf_format, vector[0]);
-    for (int k = 1; k < size; k++)
-        fprintf (stream, point_printf_sep "" point_printf_format, vector[k]);
+    outbuf_t * out = outbuf_new(stream);
+    outbuf_vector(out, vector, size);
+    outbuf_free(out);
 }
 
 void
@@ -250,15 +1054,17 @@ write_sets (FILE *outfile, const double *data, int ncols,
 {
     int size = 0;
     ASSUME(nruns > 0);
+    outbuf_t * out = outbuf_new(outfile);
     for (int set = 0; set < nruns; set++) {
         ASSUME(cumsizes[set] >= 0);
         if (set > 0)
-            fprintf (outfile, "\n");
+            outbuf_putc (out, '\n');
         for (; size < cumsizes[set]; size++) {
-            vector_fprintf (outfile, &data[ncols * size], ncols);
-            fprintf (outfile, "\n");
+            outbuf_vector (out, &data[ncols * size], ncols);
+            outbuf_putc (out, '\n');
         }
     }
+    outbuf_free(out);
     return 0;
 }
 
@@ -268,17 +1074,66 @@ write_sets_filtered (FILE *outfile, const double *data, int ncols,
 {
     int size = 0;
     ASSUME(nruns > 0);
+    outbuf_t * out = outbuf_new(outfile);
     for (int set = 0; set < nruns; set++) {
         ASSUME(cumsizes[set] >= 0);
         if (set > 0)
-            fprintf (outfile, "\n");
+            outbuf_putc (out, '\n');
         for (; size < cumsizes[set]; size++) {
             if (write_p[size]) {
-                vector_fprintf (outfile, &data[ncols * size], ncols);
-                fprintf (outfile, "\n");
+                outbuf_vector (out, &data[ncols * size], ncols);
+                outbuf_putc (out, '\n');
             }
         }
     }
+    outbuf_free(out);
     return 0;
 }
+
+/* Write the sets in binary format (see io.h).  If WRITE_P is not NULL, only
+   the points for which WRITE_P is true are written and sets that become
+   empty are omitted, as when reading the output of write_sets_filtered().
+   Returns 0 on success and -1 on a write error.  */
+int
+write_sets_binary (FILE *outfile, const double *data, int ncols,
+                   const int *cumsizes, int nruns, const bool *write_p)
+{
+    ASSUME(nruns > 0);
+    int32_t * out_cumsizes = malloc(nruns * sizeof(int32_t));
+    uint32_t nsets = 0;
+    int32_t npoints = 0;
+    for (int set = 0, size = 0; set < nruns; set++) {
+        for (; size < cumsizes[set]; size++)
+            npoints += (write_p == NULL || write_p[size]);
+        if (nsets == 0 || npoints > out_cumsizes[nsets - 1])
+            out_cumsizes[nsets++] = npoints;
+    }
+    const uint32_t bom = BINARY_BYTE_ORDER_MARK;
+    const uint32_t dtype = BINARY_DTYPE_DOUBLE;
+    const uint32_t nobjs = (uint32_t) ncols;
+    const uint64_t npoints64 = (uint64_t) npoints;
+    if (npoints == 0)
+        nsets = 0;
+    bool ok = fwrite(binary_magic, sizeof(binary_magic), 1, outfile) == 1
+        && fwrite(&bom, sizeof(bom), 1, outfile) == 1
+        && fwrite(&dtype, sizeof(dtype), 1, outfile) == 1
+        && fwrite(&nobjs, sizeof(nobjs), 1, outfile) == 1
+        && fwrite(&nsets, sizeof(nsets), 1, outfile) == 1
+        && fwrite(&npoints64, sizeof(npoints64), 1, outfile) == 1
+        && fwrite(out_cumsizes, sizeof(int32_t), nsets, outfile) == nsets;
+    free(out_cumsizes);
+    static const char padding[BINARY_DATA_ALIGNMENT] = { 0 };
+    const size_t npad = binary_data_offset(nsets) - BINARY_HEADER_SIZE
+        - nsets * sizeof(int32_t);
+    ok = ok && fwrite(padding, 1, npad, outfile) == npad;
+    const size_t n = (size_t) cumsizes[nruns - 1];
+    if (write_p == NULL) {
+        ok = ok && fwrite(data, sizeof(double) * ncols, n, outfile) == n;
+    } else {
+        for (size_t i = 0; ok && i < n; i++)
+            if (write_p[i])
+                ok = fwrite(data + i * ncols, sizeof(double), ncols, outfile) == (size_t) ncols;
+    }
+    return ok ? 0 : -1;
+}
 #endif // R_PACKAGE
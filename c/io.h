@@ -2,10 +2,10 @@
 #define EAF_INPUT_OUTPUT_H
 
 #include "config.h"
-#ifndef R_PACKAGE
-#include <stdlib.h>
 #include <stdio.h>
 #include <string.h>
+#ifndef R_PACKAGE
+#include <stdlib.h>
 #include <assert.h>
 #endif
 
@@ -15,8 +15,8 @@ static const char stdin_name[] = "<stdin>";
 
 // Longest number is -1.23456789012345e-308
 #define point_printf_format "%-22.15g"
+#define point_printf_width 22
 #define point_printf_sep    " "
-#define indicator_printf_format "%-22.15g"
 
 /* Error codes for read_data.  */
 enum ERROR_READ_DATA { READ_INPUT_FILE_EMPTY = -1,
@@ -26,12 +26,99 @@ enum ERROR_READ_DATA { READ_INPUT_FILE_EMPTY = -1,
                        ERROR_COLUMNS = -5,
 };
 
+/* Binary format of objective vectors.  read_double_data() and
+   read_int_data() detect it automatically and write_sets_binary() writes
+   it.  All values are in the byte order of the machine that wrote them:
+
+     char     magic[8] = "MOODATA1"
+     uint32_t byte-order mark = 0x01020304
+     uint32_t type of the values (BINARY_DTYPE_*)
+     uint32_t number of objectives
+     uint32_t number of sets
+     uint64_t number of points
+     int32_t  cumulative sizes of the sets
+     zero padding up to a multiple of BINARY_DATA_ALIGNMENT bytes
+     values of the points, one point after another.
+   A binary file contains exactly one dataset, anything after the values is
+   ignored.  */
+#define BINARY_HEADER_SIZE 32
+#define BINARY_DATA_ALIGNMENT 64
+#define BINARY_BYTE_ORDER_MARK 0x01020304
+enum { BINARY_DTYPE_DOUBLE = 1, BINARY_DTYPE_INT = 2 };
+
 int
 read_int_data (const char *filename, int **data_p,
                int *nobjs_p, int **cumsizes_p, int *nsets_p);
 int
 read_double_data (const char *filename, double **data_p,
                   int *nobjs_p, int **cumsizes_p, int *nsets_p);
+int
+read_int_data_parallel (const char *filename, int **data_p,
+                        int *nobjs_p, int **cumsizes_p, int *nsets_p, int nthreads);
+int
+read_double_data_parallel (const char *filename, double **data_p,
+                           int *nobjs_p, int **cumsizes_p, int *nsets_p, int nthreads);
+
+/* Read the sets of a file one at a time, so that memory use is bounded by the
+   largest set instead of the whole file.  The input may be in any format
+   accepted by read_double_data().  dataset_reader_next_set() returns 1 and
+   sets *DATA_P and *SIZE_P to the points of the next set, which are valid
+   until the next call, 0 at the end of the input, or one of the errors of
+   read_double_data().  *NOBJS_P is handled as in read_double_data().  */
+typedef struct dataset_reader dataset_reader_t;
+int dataset_reader_open (dataset_reader_t **reader_p, const char *filename);
+int dataset_reader_next_set (dataset_reader_t *reader, const double **data_p,
+                             int *nobjs_p, int *size_p);
+void dataset_reader_close (dataset_reader_t *reader);
+
+/* Buffered output.  Values are formatted into a large buffer, which is
+   written to STREAM with a single fwrite() when it is full, when
+   outbuf_flush() is called and by outbuf_free().  Output that goes to the
+   same stream must use the same outbuf_t.  Numbers are written with the
+   shortest representation that reads back as the same double (see
+   format_double.h), which is the same as "%.15g" for numbers with at most 15
+   significant digits.  */
+#define OUTBUF_SIZE (256 * 1024)
+/* Room for any single item written by the functions below, at least
+   point_printf_width + FORMAT_DOUBLE_MAXLEN.  */
+#define OUTBUF_ITEM_MAXLEN 64
+typedef struct {
+    FILE * stream;
+    size_t size;
+    char buf[OUTBUF_SIZE];
+} outbuf_t;
+
+outbuf_t * outbuf_new (FILE *stream);
+void outbuf_flush (outbuf_t *out);
+void outbuf_free (outbuf_t *out);
+void outbuf_double (outbuf_t *out, double x);
+void outbuf_point (outbuf_t *out, double x);
+void outbuf_vector (outbuf_t *out, const double *vector, int size);
+void outbuf_int (outbuf_t *out, int x);
+
+static inline void
+outbuf_reserve (outbuf_t *out, size_t n)
+{
+    if (unlikely(out->size + n > OUTBUF_SIZE))
+        outbuf_flush (out);
+}
+
+static inline void
+outbuf_putc (outbuf_t *out, char c)
+{
+    outbuf_reserve (out, 1);
+    out->buf[out->size++] = c;
+}
+
+static inline void
+outbuf_puts (outbuf_t *out, const char *s)
+{
+    const size_t len = strlen(s);
+    ASSUME(len <= OUTBUF_SIZE);
+    outbuf_reserve (out, len);
+    memcpy(out->buf + out->size, s, len);
+    out->size += len;
+}
 
 #ifndef R_PACKAGE
 
@@ -39,12 +126,16 @@ void vector_fprintf (FILE *stream, const double * vector, int size);
 void vector_printf (const double *vector, int size);
 void vector_int_fprintf (FILE *stream, const int * vector, int size);
 void vector_int_printf (const int *vector, int size);
-int read_datasets(const char * filename, double **data_p, int *ncols_p, int *datasize_p);
+int read_datasets(const char * filename, double **data_p, int *ncols_p, int *datasize_p,
+                  int nthreads);
 int write_sets (FILE *outfile, const double *data, int ncols,
                 const int *cumsizes, int nruns);
 int write_sets_filtered (FILE *outfile, const double *data, int ncols,
                          const int *cumsizes, int nruns,
                          const bool *write_p);
+int write_sets_binary (FILE *outfile, const double *data, int ncols,
+                       const int *cumsizes, int nruns,
+                       const bool *write_p);
 
 
 static inline const signed char *
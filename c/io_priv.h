@@ -1,14 +1,12 @@
 #include "config.h"
 #include <stdlib.h>
 #include <stdio.h>
-#include <string.h> /* for strerror() */
-#include <errno.h> /* for errno  */
 
 #define QUOTE(name) #name
 #define STR(macro) QUOTE(macro)
 #define objective_t_str STR(objective_t)
-#ifndef fread_objective_t
-#error "fread_objective_t is not defined"
+#ifndef parse_objective_t
+#error "parse_objective_t is not defined"
 #endif
 
 /* allocate ~512kB at once, allowing for malloc overhead */
@@ -17,9 +15,61 @@
 #endif
 #define DATA_INC (IO_SLAB_SIZE / sizeof(objective_t))
 #define CUMSIZE_INC (128)
+
+/*
+ * Read data in binary format (see io.h) from READER, appending it to the
+ * data already read, if any.
+ */
+static int
+read_objective_t_binary (block_reader_t * reader, const char *filename,
+                         objective_t **data_p, int *nobjs_p, int **cumsizes_p,
+                         int *nsets_p)
+{
+    const int nobjs = *nobjs_p;
+    const int nsets = *nsets_p;
+    binary_header_t h;
+    if (!read_binary_header(reader, filename, &h))
+        return ERROR_CONVERSION;
+    if (h.dtype != objective_t_dtype) {
+        errprintf ("%s: binary data does not contain values of type %s",
+                   filename, objective_t_str);
+        return ERROR_CONVERSION;
+    }
+    if (h.npoints == 0)
+        return READ_INPUT_FILE_EMPTY;
+    if (nobjs != 0 && (int) h.nobjs != nobjs) {
+        errprintf ("%s: input has dimension %d while previous data has dimension %d",
+                   filename, (int) h.nobjs, nobjs);
+        return (nsets == 0) ? READ_INPUT_WRONG_INITIAL_DIM : ERROR_COLUMNS;
+    }
+    const int offset = (nsets == 0) ? 0 : (*cumsizes_p)[nsets - 1];
+    if (h.npoints > (uint64_t) (INT_MAX - offset)) {
+        errprintf ("%s: too many points", filename);
+        return ERROR_CONVERSION;
+    }
+    int * cumsizes = realloc(*cumsizes_p, (nsets + h.nsets) * sizeof(int));
+    *cumsizes_p = cumsizes;
+    if (!read_binary_cumsizes(reader, filename, &h, cumsizes + nsets, offset))
+        return ERROR_CONVERSION;
+
+    const size_t ntotal = (size_t) offset * h.nobjs;
+    const size_t nvalues = (size_t) h.npoints * h.nobjs;
+    objective_t * data = realloc(*data_p, (ntotal + nvalues) * sizeof(objective_t));
+    *data_p = data;
+    if (!block_reader_read(reader, data + ntotal, nvalues * sizeof(objective_t))) {
+        errprintf ("%s: truncated binary data", filename);
+        return ERROR_CONVERSION;
+    }
+    *nobjs_p = (int) h.nobjs;
+    *nsets_p = nsets + (int) h.nsets;
+    return 0;
+}
 /*
  * Read an array of objective values from a stream.  This function may
- * be called repeatedly to add data to an existing data set.
+ * be called repeatedly to add data to an existing data set.  The stream is
+ * read in large blocks (see block_reader_next()) and parsed in memory.
+ * Data in binary format (see io.h) is detected and read directly, and
+ * compressed input (gzip or xz, if supported) is decompressed while reading.
  *
  *  nobjs : number of objectives, also the number of columns.
  */
@@ -32,14 +82,11 @@ read_objective_t_data (const char *filename, objective_t **data_p,
     int nsets    = *nsets_p;     /* number of data sets.                 */
     objective_t *data = *data_p;
 
-    FILE *instream;
-
-    if (filename == NULL) {
-        instream = stdin;
-        filename = stdin_name; /* used to diagnose errors.  */
-    } else if (unlikely(NULL == (instream = fopen (filename,"rb")))) {
-        errprintf ("%s: %s", filename, strerror (errno));
-        return ERROR_FOPEN;
+    input_source_t source;
+    int errorcode = input_source_open(&source, &filename);
+    if (unlikely(errorcode)) {
+        input_source_close(&source);
+        return errorcode;
     }
 
     size_t ntotal = 0;			/* the current element of (*datap) */
@@ -57,51 +104,56 @@ read_objective_t_data (const char *filename, objective_t **data_p,
     data = realloc (data, datasize * sizeof(objective_t));
     cumsizes = realloc (cumsizes, sizessize * sizeof(int));
 
-    /* skip over leading whitespace, comments and empty lines.  */
-    int retval;			/* return value for fscanf */
-    int column = 0,
-        line = 0;
-    do {
-        line++;
-        /* skip full lines starting with # */
-        retval = skip_comment_line (instream);
-    } while (retval == 1);
-
-    int errorcode = 0;
-    if (unlikely(retval == EOF)) { /* faster than !feof() */
-        errorcode = READ_INPUT_FILE_EMPTY;
+    block_reader_t reader;
+    block_reader_init(&reader, &source, IO_READ_BLOCK_SIZE);
+    if (block_reader_is_binary(&reader)) {
+        errorcode = read_objective_t_binary(&reader, filename, &data, &nobjs,
+                                            &cumsizes, &nsets);
         goto read_data_finish;
     }
 
-    do {
-        /* beginning of data set */
-	if ((size_t) nsets == sizessize) {
-            sizessize += CUMSIZE_INC;
-            cumsizes = realloc(cumsizes, sizessize * sizeof(int));
-        }
+    int column = 0,
+        line = 0;
+    bool empty = true;  /* no row read yet.  */
+    bool in_set = false; /* a row was read since the last empty line.  */
+    const char *p, *end;
+    while ((p = block_reader_next(&reader, &end)) != NULL) {
+        while (p < end) {
+            line++;
+            p = skip_separators(p, end);
+            /* Empty lines and lines starting with # separate data sets.  */
+            if (p == end || *p == '\n' || unlikely(*p == '#')) {
+                p = skip_line(p, end);
+                if (in_set) {
+                    nsets++; /* new data set */
+                    DEBUG2_PRINT("%s: set %d, read %d rows\n",
+                                 filename, nsets, cumsizes[nsets - 1]);
+                    in_set = false;
+                }
+                continue;
+            }
 
-	cumsizes[nsets] = (nsets == 0) ? 0 : cumsizes[nsets - 1];
+            if (!in_set) {
+                /* beginning of data set */
+                if ((size_t) nsets == sizessize) {
+                    sizessize += CUMSIZE_INC;
+                    cumsizes = realloc(cumsizes, sizessize * sizeof(int));
+                }
+                cumsizes[nsets] = (nsets == 0) ? 0 : cumsizes[nsets - 1];
+                in_set = true;
+            }
+            empty = false;
 
-        do {
             /* beginning of row */
-	    column = 0;
-
-	    do {
+            column = 0;
+            do {
                 /* new column */
                 column++;
                 objective_t number;
-                retval = fread_objective_t(instream, &number);
-                if (unlikely(retval != 1)) {
-                    char buffer[64];
-                    if (fscanf (instream, "%60[^ \t\r\n]", buffer) != 1) {
-                        errprintf ("%s: line %d column %d: "
-                                   "read error or unexpected end of file",
-                                   filename, line, column);
-                    } else {
-                        errprintf ("%s: line %d column %d: "
-                                   "could not convert string `%s' to %s",
-                                   filename, line, column, buffer, objective_t_str);
-                    }
+                const char * next = parse_objective_t(p, end, &number);
+                if (unlikely(next == NULL)) {
+                    report_conversion_error(filename, line, column, p, end,
+                                            objective_t_str);
                     errorcode = ERROR_CONVERSION;
                     goto read_data_finish;
                 }
@@ -117,57 +169,271 @@ read_objective_t_data (const char *filename, objective_t **data_p,
                              cumsizes[nsets], nsets, (double) number);
 
                 /* skip possible trailing whitespace */
-                retval = skip_trailing_whitespace(instream);
-	    } while (retval == 0);
+                p = skip_separators(next, end);
+            } while (p < end && *p != '\n');
+            if (p < end)
+                p++; /* skip newline */
 
-	    if (!nobjs)
-		nobjs = column;
+            if (!nobjs)
+                nobjs = column;
             else if (likely(column == nobjs))
                 ; /* OK */
-            else if (unlikely(cumsizes[0] == 0)) { /* just finished first row.  */
-                errprintf ("%s: line %d: input has dimension %d"
-                           " while previous data has dimension %d",
-                           filename,line, column, nobjs);
-                errorcode = READ_INPUT_WRONG_INITIAL_DIM;
+            else {
+                /* just finished first row?  */
+                errorcode = unlikely(cumsizes[0] == 0)
+                    ? READ_INPUT_WRONG_INITIAL_DIM : ERROR_COLUMNS;
+                report_columns_error(errorcode, filename, line, column, nobjs);
                 goto read_data_finish;
-            } else {
-                errprintf ("%s: line %d has different number of columns (%d)"
-                           " from first row (%d)\n",
-                           filename, line, column, nobjs);
-                errorcode = ERROR_COLUMNS;
-                goto read_data_finish;
- 	    }
-	    cumsizes[nsets]++;
-
-            /* look for an empty line */
-            line++;
-            retval = skip_comment_line (instream);
-	} while (retval == 0);
-
-	nsets++; /* new data set */
+            }
+            cumsizes[nsets]++;
+        }
+    }
+    if (in_set) {
+        nsets++; /* last data set */
         DEBUG2_PRINT("%s: set %d, read %d rows\n",
                      filename, nsets, cumsizes[nsets - 1]);
-        /* skip over successive empty lines */
+    }
+
+    if (unlikely(empty)) {
+        errorcode = READ_INPUT_FILE_EMPTY;
+        goto read_data_finish;
+    }
+
+    /* adjust to real size (saves memory but probably slower).  */
+    data = realloc (data, ntotal * sizeof(objective_t));
+    cumsizes = realloc (cumsizes, nsets * sizeof(int));
+
+read_data_finish:
+    /* An error while decompressing may look like a different error.  */
+    if (unlikely(input_source_failed(&source, filename)))
+        errorcode = ERROR_CONVERSION;
+
+    *nobjs_p = nobjs;
+    *nsets_p = nsets;
+    *cumsizes_p = cumsizes;
+    *data_p = data;
+
+    block_reader_free(&reader);
+    input_source_close(&source);
+
+    return errorcode;
+}
+
+/* Second pass: parse the rows of chunk C into DATA.  FIRST_ROW is true if
+   the first row of C is the first row read.  Stops at the first error.  */
+static void
+parse_chunk_objective_t(text_chunk_t * c, objective_t * data, int nobjs, bool first_row)
+{
+    const char * p = c->begin, * end = c->end;
+    int line = c->line0;
+    bool in_run = false;
+    c->nruns = 0;
+    c->break_first = c->break_last = false;
+    c->error = 0;
+    while (p < end) {
+        line++;
+        p = skip_separators(p, end);
+        if (p == end || *p == '\n' || unlikely(*p == '#')) {
+            p = skip_line(p, end);
+            if (c->nruns == 0)
+                c->break_first = true;
+            c->break_last = true;
+            in_run = false;
+            continue;
+        }
+        if (!in_run) {
+            text_chunk_new_run(c);
+            in_run = true;
+        }
+        c->break_last = false;
+        int column = 0;
         do {
-            line++;
-            retval = skip_comment_line (instream);
-        } while (retval == 1);
+            column++;
+            const char * next = parse_objective_t(p, end, data);
+            if (unlikely(next == NULL)) {
+                c->error = ERROR_CONVERSION;
+                c->error_line = line;
+                c->error_column = column;
+                c->error_pos = p;
+                return;
+            }
+            data++;
+            p = skip_separators(next, end);
+        } while (p < end && *p != '\n');
+        if (p < end)
+            p++; /* skip newline */
+        if (unlikely(column != nobjs)) {
+            c->error = first_row ? READ_INPUT_WRONG_INITIAL_DIM : ERROR_COLUMNS;
+            c->error_line = line;
+            c->error_column = column;
+            return;
+        }
+        first_row = false;
+        c->runs[c->nruns - 1]++;
+    }
+}
+
+/*
+ * Same as read_objective_t_data() using up to NTHREADS threads.  Each block
+ * read is split into chunks at line boundaries, which are counted and then
+ * parsed concurrently directly into their final position in DATA.  The
+ * result, including errors, is the same as read_objective_t_data().
+ */
+int
+read_objective_t_data_parallel (const char *filename, objective_t **data_p,
+                                int *nobjs_p, int **cumsizes_p, int *nsets_p,
+                                int nthreads)
+{
+    if (nthreads <= 1)
+        return read_objective_t_data(filename, data_p, nobjs_p, cumsizes_p, nsets_p);
 
-    } while (retval != EOF); /* faster than !feof() */
+    int nobjs = *nobjs_p;        /* number of objectives (and columns).  */
+    int *cumsizes = *cumsizes_p; /* cumulative sizes of data sets.       */
+    int nsets    = *nsets_p;     /* number of data sets.                 */
+    objective_t *data = *data_p;
+
+    input_source_t source;
+    int errorcode = input_source_open(&source, &filename);
+    if (unlikely(errorcode)) {
+        input_source_close(&source);
+        return errorcode;
+    }
+
+    size_t ntotal = 0;
+    size_t sizessize = 0;
+    size_t datasize = 0;
+    if (nsets > 0) {
+        ntotal = (size_t) nobjs * cumsizes[nsets - 1];
+        assert(ntotal > 0);
+        sizessize = nsets + CUMSIZE_INC;
+        datasize  = ((ntotal - 1) / DATA_INC + 1) * DATA_INC;
+    }
+    data = realloc (data, datasize * sizeof(objective_t));
+    cumsizes = realloc (cumsizes, sizessize * sizeof(int));
+
+    const int max_chunks = nthreads * IO_PARALLEL_CHUNKS_PER_THREAD;
+    text_chunk_t * chunks = calloc((size_t) max_chunks, sizeof(text_chunk_t));
+    block_reader_t reader;
+    block_reader_init(&reader, &source, (size_t) max_chunks * IO_PARALLEL_CHUNK_SIZE);
+    if (block_reader_is_binary(&reader)) {
+        errorcode = read_objective_t_binary(&reader, filename, &data, &nobjs,
+                                            &cumsizes, &nsets);
+        goto read_data_finish;
+    }
+
+    const bool first_set = (nsets == 0);
+    int line = 0;
+    bool empty = true;   /* no row read yet.  */
+    bool in_set = false; /* a row was read since the last empty line.  */
+    const char *p, *end;
+    while ((p = block_reader_next(&reader, &end)) != NULL) {
+        const int nchunks = split_text_chunks(chunks, max_chunks, p, end);
+        if (!nobjs)
+            nobjs = first_row_ncolumns(p, end);
+#ifdef _OPENMP
+#pragma omp parallel for schedule(dynamic, 1) num_threads(nthreads)
+#endif
+        for (int c = 0; c < nchunks; c++)
+            count_text_chunk(&chunks[c]);
+
+        size_t needed = ntotal;
+        for (int c = 0; c < nchunks; c++) {
+            chunks[c].line0 = line;
+            line += chunks[c].nlines;
+            chunks[c].offset = needed;
+            needed += chunks[c].nvalues;
+        }
+        if (needed > datasize) {
+            datasize = MAX(needed, 2 * datasize);
+            data = realloc (data, datasize * sizeof(objective_t));
+        }
+        /* The chunk with the first row read, if any.  */
+        int first_chunk = -1;
+        if (first_set && empty) {
+            for (int c = 0; c < nchunks && first_chunk < 0; c++)
+                if (chunks[c].nvalues > 0)
+                    first_chunk = c;
+        }
+        /* Iteration -1 reads (and decompresses) the next block while the
+           other threads parse this one.  */
+#ifdef _OPENMP
+#pragma omp parallel for schedule(dynamic, 1) num_threads(nthreads)
+#endif
+        for (int c = -1; c < nchunks; c++) {
+            if (c < 0)
+                block_reader_prefetch(&reader);
+            else
+                parse_chunk_objective_t(&chunks[c], data + chunks[c].offset, nobjs,
+                                        c == first_chunk);
+        }
+
+        /* Join the runs of rows into sets.  */
+        for (int c = 0; c < nchunks; c++) {
+            const text_chunk_t * chunk = &chunks[c];
+            if (chunk->break_first && in_set) {
+                nsets++;
+                in_set = false;
+            }
+            for (size_t r = 0; r < chunk->nruns; r++) {
+                if (r > 0) {
+                    nsets++;
+                    in_set = false;
+                }
+                if (!in_set) {
+                    if ((size_t) nsets == sizessize) {
+                        sizessize += CUMSIZE_INC;
+                        cumsizes = realloc(cumsizes, sizessize * sizeof(int));
+                    }
+                    cumsizes[nsets] = (nsets == 0) ? 0 : cumsizes[nsets - 1];
+                    in_set = true;
+                }
+                cumsizes[nsets] += chunk->runs[r];
+                empty = false;
+            }
+            if (unlikely(chunk->error)) {
+                errorcode = chunk->error;
+                if (errorcode == ERROR_CONVERSION)
+                    report_conversion_error(filename, chunk->error_line, chunk->error_column,
+                                            chunk->error_pos, chunk->end, objective_t_str);
+                else
+                    report_columns_error(errorcode, filename, chunk->error_line,
+                                         chunk->error_column, nobjs);
+                goto read_data_finish;
+            }
+            if (chunk->break_last && in_set) {
+                nsets++;
+                in_set = false;
+            }
+        }
+        ntotal = needed;
+    }
+    if (in_set)
+        nsets++; /* last data set */
+
+    if (unlikely(empty)) {
+        errorcode = READ_INPUT_FILE_EMPTY;
+        goto read_data_finish;
+    }
 
     /* adjust to real size (saves memory but probably slower).  */
     data = realloc (data, ntotal * sizeof(objective_t));
     cumsizes = realloc (cumsizes, nsets * sizeof(int));
 
 read_data_finish:
+    /* An error while decompressing may look like a different error.  */
+    if (unlikely(input_source_failed(&source, filename)))
+        errorcode = ERROR_CONVERSION;
 
     *nobjs_p = nobjs;
     *nsets_p = nsets;
     *cumsizes_p = cumsizes;
     *data_p = data;
 
-    if (instream != stdin)
-        fclose(instream);
+    for (int c = 0; c < max_chunks; c++)
+        free(chunks[c].runs);
+    free(chunks);
+    block_reader_free(&reader);
+    input_source_close(&source);
 
     return errorcode;
 }
@@ -73,148 +73,332 @@ OPTION_VERSION_STR
 " -s, --suffix=STRING Create an output file for each input file by appending\n"
 "                     this suffix. This is ignored when reading from stdin. \n"
 "                     If missing, output is sent to stdout.                 \n"
+OPTION_JOBS_STR
 "\n");
 }
 
 static void
-fprint_hvc(FILE * outfile, const double * hvc, size_t n)
+print_hvc(outbuf_t * out, const double * hvc, size_t n)
 {
-    for (size_t i = 0; i < n; i++)
-        fprintf(outfile, indicator_printf_format "\n", hvc[i]);
-    fprintf(outfile, "\n");
+    for (size_t i = 0; i < n; i++) {
+        outbuf_point(out, hvc[i]);
+        outbuf_putc(out, '\n');
+    }
+    outbuf_putc(out, '\n');
 }
 
-/*
-   FILENAME: input filename. If NULL, read stdin.
-
-   REFERENCE: reference point. If NULL, use MAXIMUM.
-
-   MAXIMUM: maximum objective vector. If NULL, caculate it from the
-   input file.
-
-   NOBJ_P: pointer to number of objectives. If NULL, calculate it from
-   input file.
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+/* Timer_start() is not thread-safe, so measure wall-clock time per set when
+   sets are computed in parallel.  */
+static inline double
+set_timer_start(void)
+{
+#ifdef _OPENMP
+    return omp_get_wtime();
+#else
+    Timer_start();
+    return 0;
+#endif
+}
 
-*/
+static inline double
+set_timer_elapsed(double start)
+{
+#ifdef _OPENMP
+    return omp_get_wtime() - start;
+#else
+    (void) start;
+    return Timer_elapsed_virtual();
+#endif
+}
 
+/* Copy the rest of SRC to DST.  */
 static void
-hv_file (const char *filename, double *reference,
-         double *maximum, double *minimum, int *nobj_p)
+copy_file_contents(FILE * dst, FILE * src)
 {
-    double *data = NULL;
-    int *cumsizes = NULL;
-    int cumsize;
-    int nruns = 0;
-    int n;
-    int nobj = *nobj_p;
-    char *outfilename = NULL;
-    FILE *outfile = stdout;
+    char buf[BUFSIZ];
+    size_t n;
+    while ((n = fread(buf, 1, sizeof(buf), src)) > 0)
+        fwrite(buf, 1, n, dst);
+}
 
-    handle_read_data_error(
-        read_double_data (filename, &data, &nobj, &cumsizes, &nruns), filename);
+/* Calculate and print the hypervolume of each set of FILENAME with respect
+   to REFERENCE, reading one set at a time.  Only the results are kept, and
+   they are printed once the whole file has been read, so that the output,
+   warnings and errors are the same as those of hv_files().  With
+   --contributions, each set's contributions are written to a temporary file
+   as soon as they are computed, thus memory use is still bounded by the
+   largest set.  */
+static void
+hv_file (const char *filename, const double *reference, int *nobj_p)
+{
+    dataset_reader_t *reader = open_dataset_reader(filename);
+    const double *points;
+    int size = 0;
+    read_next_set(reader, filename, &points, nobj_p, &size);
     if (!filename)
         filename = stdin_name;
 
-    if (filename != stdin_name && suffix) {
-        outfilename = m_strcat(filename, suffix);
-        outfile = fopen (outfilename, "w");
-        if (outfile == NULL) {
-            errprintf ("%s: %s\n", outfilename, strerror(errno));
+    const int nobj = *nobj_p;
+    bool warn = false, failed = false;
+    vector_double volumes;
+    vector_double_ctor_zero(&volumes);
+    double *hvc = NULL;
+    size_t hvc_size = 0;
+    FILE *spool = NULL;
+    outbuf_t *spool_out = NULL;
+    if (contributions_flag) {
+        if ((spool = tmpfile()) == NULL)
+            fatal_error("cannot create temporary file: %s", strerror(errno));
+        spool_out = outbuf_new(spool);
+    }
+    do {
+        for (int i = 0; i < nobj * size && !warn; i++)
+            warn = (reference[i % nobj] <= points[i]);
+        /* Sets after the first one without hypervolume are not printed, but
+           the rest of the file is still read to report any error in it.  */
+        if (failed)
+            continue;
+        double volume;
+        if (contributions_flag) {
+            if ((size_t) size > hvc_size) {
+                hvc_size = (size_t) size;
+                hvc = realloc(hvc, hvc_size * sizeof(*hvc));
+            }
+            /* The reader owns POINTS until the next set is read.  */
+            volume = hv_contributions(hvc, points, nobj, size, reference);
+            if (volume != 0.0)
+                print_hvc(spool_out, hvc, (size_t) size);
+        } else {
+            volume = fpli_hv(points, nobj, size, reference);
+        }
+        vector_double_push_back(&volumes, volume);
+        failed = (volume == 0.0);
+    } while (read_next_set(reader, filename, &points, nobj_p, &size));
+    dataset_reader_close(reader);
+    free(hvc);
+
+    char *outfilename;
+    FILE *outfile = open_output_file(filename, suffix, &outfilename);
+    if (warn)
+        warnprintf ("%s: some points do not strictly dominate "
+                    "the reference point and they will be discarded",
+                    filename);
+    if (contributions_flag) {
+        outbuf_free(spool_out);
+        rewind(spool);
+        copy_file_contents(outfile, spool);
+        fclose(spool);
+    }
+    outbuf_t *out = outbuf_new(outfile);
+    for (size_t n = 0; n < vector_double_size(&volumes); n++) {
+        const double volume = vector_double_at(&volumes, n);
+        if (volume == 0.0) {
+            outbuf_free(out);
+            errprintf ("none of the points strictly dominates the reference point\n");
             exit (EXIT_FAILURE);
         }
+        if (!contributions_flag) {
+            outbuf_point(out, volume);
+            outbuf_putc(out, '\n');
+        }
     }
+    outbuf_free(out);
+    close_output_file(outfile, filename, outfilename, verbose_flag);
+    vector_double_dtor(&volumes);
+}
 
-    if (union_flag) {
-        cumsizes[0] = cumsizes[nruns - 1];
-        nruns = 1;
-    }
+/*
+   Calculate and print the hypervolume of each set of NFILES input files read
+   by read_input_files(), computing the sets in parallel with up to NTHREADS
+   threads.  The output of each file is printed in order once all sets have
+   been computed.
 
-    if (verbose_flag >= 2)
-        printf("# file: %s\n", filename);
+   REFERENCE: reference point. If NULL, use MAXIMUM.
 
-    bool needs_minimum = (minimum == NULL);
-    if (needs_minimum) {
-        data_bounds (&minimum, &maximum, data, nobj, cumsizes[nruns-1]);
-        if (verbose_flag >= 2) {
-            printf ("# minimum:   ");
-            vector_printf (minimum, nobj);
-            printf ("\n");
-            printf ("# maximum:   ");
-            vector_printf (maximum, nobj);
-            printf ("\n");
-        }
-    }
+   MAXIMUM, MINIMUM: bounds of all input files. If NULL, calculate them for
+   each file.
 
-    if (reference != NULL) {
-        for (n = 0; n < nobj; n++) {
-            if (reference[n] <= maximum[n]) {
-                warnprintf ("%s: some points do not strictly dominate "
-                            "the reference point and they will be discarded",
-                            filename);
-                break;
-            }
+*/
+static void
+hv_files (input_file_t *files, int nfiles, const double *reference,
+          const double *maximum, const double *minimum, int nobj, int nthreads)
+{
+    if (nfiles < 1)
+        return;
+    const bool needs_minimum = (minimum == NULL);
+    double *refs = malloc(sizeof(double) * nobj * nfiles);
+    double **hvc = calloc(nfiles, sizeof(double *));
+    int k, n;
+
+    for (k = 0; k < nfiles; k++) {
+        input_file_t *file = files + k;
+        if (file->err != 0)
+            continue;
+        if (union_flag) {
+            file->cumsizes[0] = file->cumsizes[file->nruns - 1];
+            file->nruns = 1;
         }
-    } else {
-        reference = malloc(nobj * sizeof(double));
+        const double *file_minimum = needs_minimum ? file->minimum : minimum;
+        const double *file_maximum = needs_minimum ? file->maximum : maximum;
+        double *file_reference = refs + nobj * k;
         for (n = 0; n < nobj; n++) {
             /* default reference point is: */
-            reference[n] = maximum[n] + 0.1 * (maximum[n] - minimum[n]);
+            file_reference[n] = reference ? reference[n]
+                : file_maximum[n] + 0.1 * (file_maximum[n] - file_minimum[n]);
             /* so that extreme points have some influence. */
         }
+        if (contributions_flag)
+            hvc[k] = malloc(sizeof(double) * file->cumsizes[file->nruns - 1]);
     }
 
-    if (needs_minimum) {
-        free(minimum);
-        free(maximum);
+    int nsets;
+    int *set_file = input_files_sets(files, nfiles, &nsets);
+    double *volume = malloc(sizeof(double) * 2 * MAX(nsets, 1));
+    double *time_elapsed = volume + MAX(nsets, 1);
+    if (nthreads < 1) nthreads = 1;
+#ifdef _OPENMP
+#pragma omp parallel for schedule(dynamic, 1) num_threads(nthreads) if (nthreads > 1 && nsets > 1)
+#endif
+    for (int t = 0; t < nsets; t++) {
+        const int f = set_file[t];
+        const input_file_t *file = files + f;
+        const int set = t - file->first_set;
+        const int cumsize = (set == 0) ? 0 : file->cumsizes[set - 1];
+        const int size = file->cumsizes[set] - cumsize;
+        const double *points = &file->data[nobj * cumsize];
+        double start = set_timer_start();
+        volume[t] = contributions_flag
+            ? hv_contributions(hvc[f] + cumsize, points, nobj, size, refs + nobj * f)
+            : fpli_hv(points, nobj, size, refs + nobj * f);
+        time_elapsed[t] = set_timer_elapsed(start);
     }
 
-    if (verbose_flag >= 2) {
-        printf ("# reference: ");
-        vector_printf (reference, nobj);
-        printf ("\n");
-    }
+    for (k = 0; k < nfiles; k++) {
+        const input_file_t *file = files + k;
+        const char *filename = file->filename;
+        handle_read_data_error(file->err, filename);
+        if (!filename)
+            filename = stdin_name;
 
-    double * hvc = NULL;
-    for (n = 0, cumsize = 0; n < nruns; cumsize = cumsizes[n], n++) {
-        Timer_start ();
-        double volume, time_elapsed;
-        if (contributions_flag) {
-            hvc = realloc(hvc, (cumsizes[n] - cumsize) * sizeof(*hvc));
-            volume = hv_contributions(hvc, &data[nobj * cumsize], nobj, cumsizes[n] - cumsize, reference);
-        } else {
-            volume = fpli_hv(&data[nobj * cumsize], nobj, cumsizes[n] - cumsize, reference);
+        char *outfilename;
+        FILE *outfile = open_output_file(filename, suffix, &outfilename);
+
+        if (verbose_flag >= 2)
+            printf("# file: %s\n", filename);
+
+        const double *file_maximum = needs_minimum ? file->maximum : maximum;
+        if (needs_minimum && verbose_flag >= 2) {
+            printf ("# minimum:   ");
+            vector_printf (file->minimum, nobj);
+            printf ("\n");
+            printf ("# maximum:   ");
+            vector_printf (file_maximum, nobj);
+            printf ("\n");
         }
-        if (volume == 0.0) {
-            errprintf ("none of the points strictly dominates the reference point\n");
-            exit (EXIT_FAILURE);
+
+        if (reference != NULL) {
+            for (n = 0; n < nobj; n++) {
+                if (reference[n] <= file_maximum[n]) {
+                    warnprintf ("%s: some points do not strictly dominate "
+                                "the reference point and they will be discarded",
+                                filename);
+                    break;
+                }
+            }
         }
-        time_elapsed = Timer_elapsed_virtual();
-        if (contributions_flag) {
-            fprint_hvc(outfile, hvc, cumsizes[n] - cumsize);
-        } else {
-            fprintf (outfile, indicator_printf_format "\n", volume);
+
+        if (verbose_flag >= 2) {
+            printf ("# reference: ");
+            vector_printf (refs + nobj * k, nobj);
+            printf ("\n");
         }
-        if (verbose_flag >= 2)
-            fprintf (outfile, "# Time: %f seconds\n", time_elapsed);
+
+        outbuf_t *out = outbuf_new(outfile);
+        for (n = 0; n < file->nruns; n++) {
+            const int t = file->first_set + n;
+            if (volume[t] == 0.0) {
+                outbuf_free(out);
+                errprintf ("none of the points strictly dominates the reference point\n");
+                exit (EXIT_FAILURE);
+            }
+            if (contributions_flag) {
+                const int cumsize = (n == 0) ? 0 : file->cumsizes[n - 1];
+                print_hvc(out, hvc[k] + cumsize, (size_t) (file->cumsizes[n] - cumsize));
+            } else {
+                outbuf_point(out, volume[t]);
+                outbuf_putc(out, '\n');
+            }
+            if (verbose_flag >= 2) {
+                outbuf_flush(out);
+                fprintf (outfile, "# Time: %f seconds\n", time_elapsed[t]);
+            }
+        }
+        outbuf_free(out);
+
+        close_output_file(outfile, filename, outfilename, verbose_flag);
+        free(hvc[k]);
     }
-    if (contributions_flag)
-        free(hvc);
-    free(data);
-    free(cumsizes);
-
-    if (outfilename) {
-        if (verbose_flag)
-            fprintf (stderr, "# %s -> %s\n", filename, outfilename);
-        fclose (outfile);
-        free (outfilename);
+    free(volume);
+    free(set_file);
+    free(hvc);
+    free(refs);
+}
+
+/* Calculate the hypervolume of the sets of NUMFILES files, reading several
+   files at once with read_input_files().  */
+static void
+hv_batches (const char **filenames, int numfiles, const double *reference,
+            int *nobj_p, int nthreads)
+{
+    int nobj = *nobj_p;
+    /* Without a reference point, the bounds of all input files are needed
+       before computing anything, so all files are kept in memory.
+       Otherwise, read just enough files at once to keep all threads busy.  */
+    const bool global_bounds = (reference == NULL && numfiles > 1);
+    const int batch = global_bounds ? numfiles : input_files_batch(numfiles, nthreads);
+    input_file_t *files = malloc(sizeof(input_file_t) * batch);
+    double *maximum = NULL;
+    double *minimum = NULL;
+    for (int start = 0; start < numfiles; start += batch) {
+        int nfiles = MIN(batch, numfiles - start);
+        for (int k = 0; k < nfiles; k++)
+            files[k] = (input_file_t) { .filename = filenames[start + k] };
+        /* The bounds of each file are calculated while reading it.  */
+        read_input_files(files, nfiles, &nobj, true, nthreads);
+
+        if (global_bounds) {
+            /* Calculate the maximum among all input files to use as
+               reference point.  */
+            for (int k = 0; k < nfiles; k++) {
+                handle_read_data_error(files[k].err, files[k].filename);
+                data_bounds(&minimum, &maximum, files[k].minimum, nobj, 1);
+                data_bounds(&minimum, &maximum, files[k].maximum, nobj, 1);
+            }
+            if (verbose_flag >= 2) {
+                printf ("# maximum:");
+                vector_printf (maximum, nobj);
+                printf ("\n");
+                printf ("# minimum:");
+                vector_printf (minimum, nobj);
+                printf ("\n");
+            }
+        }
+        hv_files (files, nfiles, reference, maximum, minimum, nobj, nthreads);
+        input_files_free(files, nfiles);
     }
+    free(files);
+    free(minimum);
+    free(maximum);
     *nobj_p = nobj;
 }
 
 int main(int argc, char *argv[])
 {
     /* See the man page for getopt_long for an explanation of these fields.  */
-    static const char short_options[] = "hVvqucr:s:S";
+    static const char short_options[] = "hVvqucr:s:j:S";
     static const struct option long_options[] = {
         {"help",       no_argument,       NULL, 'h'},
         {"version",    no_argument,       NULL, 'V'},
@@ -224,6 +408,7 @@ int main(int argc, char *argv[])
         {"union",      no_argument,       NULL, 'u'},
         {"contributions", no_argument,    NULL, 'c'},
         {"suffix",     required_argument, NULL, 's'},
+        {"jobs",       required_argument, NULL, 'j'},
         {NULL, 0, NULL, 0} /* marks end of list */
     };
 
@@ -231,6 +416,7 @@ int main(int argc, char *argv[])
 
     double *reference = NULL;
     int nobj = 0;
+    int nthreads = 1;
 
     int opt; /* it's actually going to hold a char.  */
     int longopt_index;
@@ -253,6 +439,10 @@ int main(int argc, char *argv[])
               suffix = optarg;
               break;
 
+          case 'j': // --jobs
+              nthreads = parse_cmdline_jobs(optarg);
+              break;
+
           case 'q': // --quiet
               verbose_flag = 0;
               break;
@@ -267,34 +457,19 @@ int main(int argc, char *argv[])
     }
 
     int numfiles = argc - optind;
-    if (numfiles < 1) /* Read stdin.  */
-        hv_file (NULL, reference, NULL, NULL, &nobj);
-    else if (numfiles == 1) {
-        hv_file (argv[optind], reference, NULL, NULL, &nobj);
+    const char *stdin_file[] = { NULL };
+    const char **filenames = (numfiles < 1) /* Read stdin.  */
+        ? stdin_file : (const char **) argv + optind;
+    if (numfiles < 1)
+        numfiles = 1;
+
+    /* Each set can be computed as soon as it is read if the reference point
+       is known and nothing else depends on the whole file.  */
+    if (nthreads == 1 && reference != NULL && !union_flag && verbose_flag < 2) {
+        for (int k = 0; k < numfiles; k++)
+            hv_file (filenames[k], reference, &nobj);
     } else {
-        int k;
-        double *maximum = NULL;
-        double *minimum = NULL;
-        if (reference == NULL) {
-            /* Calculate the maximum among all input files to use as
-               reference point.  */
-            for (k = 0; k < numfiles; k++)
-                file_bounds(argv[optind + k], &maximum, &minimum, &nobj);
-
-            if (verbose_flag >= 2) {
-                printf ("# maximum:");
-                vector_printf (maximum, nobj);
-                printf ("\n");
-                printf ("# minimum:");
-                vector_printf (minimum, nobj);
-                printf ("\n");
-            }
-        }
-        for (k = 0; k < numfiles; k++)
-            hv_file (argv[optind + k], reference, maximum, minimum, &nobj);
-
-        free(minimum);
-        free(maximum);
+        hv_batches (filenames, numfiles, reference, &nobj, nthreads);
     }
 
     if (reference) free(reference);
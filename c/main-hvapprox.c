@@ -37,6 +37,12 @@
 static int verbose_flag = 1;
 static bool union_flag = false;
 static char *suffix = NULL;
+static int nthreads = 1;
+/* Directions are computed once and reused for all input sets.  */
+static hvapprox_directions_t * directions = NULL;
+static const char * save_directions_filename = NULL;
+/* Whether there are several input files.  */
+static bool many_files = false;
 
 enum approx_method_t { DZ2019_MC=1, DZ2019_HW=2 };
 
@@ -68,6 +74,11 @@ OPTION_VERSION_STR
 "                     2: Hua-Wang deterministic sampling (default).         \n"
 " -S, --seed=S        Seed of the random number generator (S: positive integer).\n"
 "                     Only method=1.                                        \n"
+" -j, --jobs=N        use up to N threads. The result does not depend on N. \n"
+" -d, --directions=FILE read the directions from FILE instead of generating \n"
+"                     them (--nsamples, --method and --seed are ignored).   \n"
+"     --save-directions=FILE save the directions to FILE for use with       \n"
+"                     --directions.                                         \n"
 "\n");
 }
 
@@ -100,7 +111,8 @@ hvapprox_file (const char *filename, double *reference,
     FILE *outfile = stdout;
 
     handle_read_data_error(
-        read_double_data (filename, &data, &nobj, &cumsizes, &nruns), filename);
+        read_double_data_parallel (filename, &data, &nobj, &cumsizes, &nruns, nthreads),
+        filename);
     if (!filename)
         filename = stdin_name;
 
@@ -158,33 +170,65 @@ hvapprox_file (const char *filename, double *reference,
         printf ("\n");
     }
 
-    // Minimise everything by default.
-    const bool * maximise = new_bool_maximise((dimension_t) nobj, false);
-    for (n = 0, cumsize = 0; n < nruns; cumsize = cumsizes[n], n++) {
-        Timer_start ();
-
-        double volume;
+    /* Keeping all the directions takes NSAMPLES * NOBJ doubles, thus a single
+       set computes them on the fly, unless they must be saved.  */
+    const bool on_the_fly = (directions == NULL && save_directions_filename == NULL
+                             && !many_files && nruns == 1);
+    if (on_the_fly) {
+        // Nothing to do.
+    } else if (directions == NULL) {
         switch (hv_approx_method) {
           case DZ2019_MC:
-              volume = hv_approx_normal(&data[nobj * cumsize], nobj, cumsizes[n] - cumsize, reference, maximise, nsamples, seed);
+              directions = hvapprox_directions_normal(nobj, nsamples, seed, nthreads);
               break;
           case DZ2019_HW:
-              volume = hv_approx_hua_wang(&data[nobj * cumsize], nobj, cumsizes[n] - cumsize, reference, maximise, nsamples);
+              directions = hvapprox_directions_hua_wang(nobj, nsamples, nthreads);
               break;
           default:
               unreachable();
         }
+        if (save_directions_filename
+            && hvapprox_directions_save(directions, save_directions_filename) != 0)
+            fatal_error("%s: %s", save_directions_filename, strerror(errno));
+    } else if (hvapprox_directions_nobjs(directions) != nobj) {
+        fatal_error("%s: number of objectives (%d) does not match the directions (%d)",
+                    filename, nobj, hvapprox_directions_nobjs(directions));
+    }
+
+    // Minimise everything by default.
+    const bool * maximise = new_bool_maximise((dimension_t) nobj, false);
+    outbuf_t *out = outbuf_new(outfile);
+    for (n = 0, cumsize = 0; n < nruns; cumsize = cumsizes[n], n++) {
+        Timer_start ();
+
+        const double *points = &data[nobj * cumsize];
+        const int npoints = cumsizes[n] - cumsize;
+        double volume;
+        if (!on_the_fly)
+            volume = hv_approx_directions(directions, points, nobj, npoints,
+                                          reference, maximise, nthreads);
+        else if (hv_approx_method == DZ2019_MC)
+            volume = hv_approx_normal(points, nobj, npoints, reference, maximise,
+                                      nsamples, seed, nthreads);
+        else
+            volume = hv_approx_hua_wang(points, nobj, npoints, reference, maximise,
+                                        nsamples, nthreads);
 
         if (volume == 0.0) {
+            outbuf_free(out);
             fatal_error("none of the points strictly dominates the reference point\n");
         }
 
         double time_elapsed = Timer_elapsed_virtual ();
 
-        fprintf (outfile, indicator_printf_format "\n", volume);
-        if (verbose_flag >= 2)
+        outbuf_point (out, volume);
+        outbuf_putc (out, '\n');
+        if (verbose_flag >= 2) {
+            outbuf_flush (out);
             fprintf (outfile, "# Time: %f seconds\n", time_elapsed);
+        }
     }
+    outbuf_free(out);
 
     if (outfilename) {
         if (verbose_flag)
@@ -205,7 +249,8 @@ hvapprox_file (const char *filename, double *reference,
 int main(int argc, char *argv[])
 {
     /* See the man page for getopt_long for an explanation of these fields.  */
-    static const char short_options[] = "hVvqur:s:n:m:S:";
+    enum { SAVE_DIRECTIONS_OPT = CHAR_MAX + 1 };
+    static const char short_options[] = "hVvqur:s:n:m:S:j:d:";
     static const struct option long_options[] = {
         {"help",       no_argument,       NULL, 'h'},
         {"version",    no_argument,       NULL, 'V'},
@@ -217,6 +262,9 @@ int main(int argc, char *argv[])
         {"method",     required_argument, NULL, 'm'},
         {"nsamples",   required_argument, NULL, 'n'},
         {"seed",       required_argument, NULL, 'S'},
+        {"jobs",       required_argument, NULL, 'j'},
+        {"directions", required_argument, NULL, 'd'},
+        {"save-directions", required_argument, NULL, SAVE_DIRECTIONS_OPT},
         {NULL, 0, NULL, 0} /* marks end of list */
     };
 
@@ -275,6 +323,22 @@ int main(int argc, char *argv[])
               seed = (uint32_t) value;
               break;
           }
+          case 'j': // --jobs
+              nthreads = parse_cmdline_jobs(optarg);
+              break;
+
+          case 'd': // --directions
+              if (directions != NULL)
+                  fatal_error("--directions can only be given once");
+              directions = hvapprox_directions_load(optarg);
+              if (directions == NULL)
+                  fatal_error("%s: cannot read directions", optarg);
+              break;
+
+          case SAVE_DIRECTIONS_OPT: // --save-directions
+              save_directions_filename = optarg;
+              break;
+
         case 'q': // --quiet
             verbose_flag = 0;
             break;
@@ -288,7 +352,11 @@ int main(int argc, char *argv[])
         }
     }
 
-    if (nsamples == 0) {
+    if (directions != NULL) {
+        nsamples = hvapprox_directions_nsamples(directions);
+        if (save_directions_filename)
+            fatal_error("cannot use --save-directions with --directions");
+    } else if (nsamples == 0) {
         fatal_error("must specify a value for --nsamples, for example, --nsamples 100000");
     }
 
@@ -303,6 +371,7 @@ int main(int argc, char *argv[])
         printf("# seed: %"PRIu32 "\n# nsamples: %lu\n", seed, (unsigned long) nsamples);
 
     int numfiles = argc - optind;
+    many_files = (numfiles > 1);
     if (numfiles < 1) /* Read stdin.  */
         hvapprox_file(NULL, reference, NULL, NULL, &nobj, nsamples, hv_approx_method, seed);
 
@@ -334,6 +403,7 @@ int main(int argc, char *argv[])
         free(maximum);
     }
 
+    hvapprox_directions_free(directions);
     if (reference) free(reference);
     return EXIT_SUCCESS;
 }
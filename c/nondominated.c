@@ -50,6 +50,7 @@ static bool check_flag = true;
 static bool filter_flag = false;
 static bool normalise_flag = false;
 static bool force_bounds_flag = false;
+static bool binary_flag = false;
 static const char *suffix = "_dat";
 
 static void usage(void)
@@ -77,6 +78,9 @@ OPTION_MAXIMISE_STR
 " -U, --union         consider each file as a whole approximation set,      \n"
 "                     (by default, approximation sets are separated by an   \n"
 "                     empty line within a file);                            \n"
+" -B, --binary        write output files in binary format (input files in   \n"
+"                     binary format are always detected). With no other    \n"
+"                     option below, convert the input files.                \n"
 " -s, --suffix=STRING suffix to add to output files. Default is \"%s\".     \n"
 "                     The empty string means overwrite the input file.      \n"
 "                     This is ignored when reading from stdin because output\n"
@@ -435,22 +439,26 @@ process_file (const char *filename,
 
     /* Write out nondominated sets.  */
     if (filter_flag || agree || normalise_flag || force_bounds_flag
-        || logarithm_flag) {
+        || logarithm_flag || binary_flag) {
 
         const char *outfilename = "<stdout>";
         FILE *outfile = stdout;
         if (filename != stdin_name) {
             outfilename = m_strcat(filename, suffix);
-            outfile = fopen (outfilename, "w");
+            outfile = fopen (outfilename, binary_flag ? "wb" : "w");
             if (outfile == NULL)
                 fatal_error("%s: %s\n", outfilename, strerror(errno));
         }
-        if (verbose_flag)
+        if (verbose_flag && !binary_flag)
             print_output_header (outfile, filename, nobj, minmax, agree,
                                  lrange, urange, lbound, ubound,
                                  logarithm);
 
-        if (filter_flag && dominated_found)
+        if (binary_flag) {
+            if (write_sets_binary (outfile, points, nobj, cumsizes, nsets,
+                                   (filter_flag && dominated_found) ? nondom : NULL))
+                fatal_error("%s: %s\n", outfilename, strerror(errno));
+        } else if (filter_flag && dominated_found)
             write_sets_filtered (outfile, points, nobj, cumsizes, nsets, nondom);
         else
             write_sets (outfile, points, nobj, cumsizes, nsets);
@@ -494,7 +502,7 @@ int main(int argc, char *argv[])
     int nobj = 0;
 
     /* see the man page for getopt_long for an explanation of these fields */
-    static const char short_options[] = "hVvqfo:a:n:u:l:Us:b";
+    static const char short_options[] = "hVvqfo:a:n:u:l:Us:bB";
     static const struct option long_options[] = {
         {"help",       no_argument,       NULL, 'h'},
         {"version",    no_argument,       NULL, 'V'},
@@ -512,6 +520,7 @@ int main(int argc, char *argv[])
         {"lower-bound",required_argument, NULL, 'l'},
         {"union",      no_argument,       NULL, 'U'},
         {"suffix",     required_argument, NULL, 's'},
+        {"binary",     no_argument,       NULL, 'B'},
         {"log",        required_argument, NULL, 'L'},
         {NULL, 0, NULL, 0} /* marks end of list */
     };
@@ -589,6 +598,10 @@ int main(int argc, char *argv[])
             suffix = optarg;
             break;
 
+        case 'B': // --binary
+            binary_flag = true;
+            break;
+
         case 'L': // --log
             logarithm = read_bitvector (optarg, &nobj);
             if (logarithm == NULL)
@@ -0,0 +1,94 @@
+#ifndef MOOCORE_POOL_H_
+#define MOOCORE_POOL_H_
+/*
+  Pool of fixed-size objects.
+
+  Objects are carved out of large chunks, so allocating is usually a
+  pointer increment and consecutive objects are contiguous in memory.
+  pool_free() puts an object in a free list to be reused by the next
+  pool_alloc().  Nothing is returned to the system until pool_dtor(),
+  which releases all objects at once.
+*/
+#include <stdlib.h>
+#include "common.h"
+
+#define POOL_ALIGN 16
+
+typedef struct pool_chunk {
+    struct pool_chunk *next;
+} pool_chunk_t;
+
+typedef struct {
+    size_t objsize;
+    size_t chunk_nobjs;
+    pool_chunk_t *chunks;
+    char *cur;
+    char *end;
+    void *free_list;
+} pool_t;
+
+static inline size_t
+pool_round_size(size_t size)
+{
+    return (size + POOL_ALIGN - 1) / POOL_ALIGN * POOL_ALIGN;
+}
+
+static inline void
+pool_ctor(pool_t *pool, size_t objsize, size_t chunk_nobjs)
+{
+    // The free list is stored in the objects themselves.
+    objsize = MAX(objsize, sizeof(void *));
+    pool->objsize = pool_round_size(objsize);
+    pool->chunk_nobjs = MAX(chunk_nobjs, (size_t) 64);
+    pool->chunks = NULL;
+    pool->cur = pool->end = NULL;
+    pool->free_list = NULL;
+}
+
+static inline void
+pool_dtor(pool_t *pool)
+{
+    pool_chunk_t *chunk = pool->chunks;
+    while (chunk) {
+        pool_chunk_t *next = chunk->next;
+        free(chunk);
+        chunk = next;
+    }
+    pool->chunks = NULL;
+    pool->cur = pool->end = NULL;
+    pool->free_list = NULL;
+}
+
+static inline void *
+pool_alloc(pool_t *pool)
+{
+    if (pool->free_list) {
+        void *p = pool->free_list;
+        pool->free_list = *(void **) p;
+        return p;
+    }
+    if (unlikely(pool->cur == pool->end)) {
+        const size_t header = pool_round_size(sizeof(pool_chunk_t));
+        size_t size = header + pool->objsize * pool->chunk_nobjs;
+        pool_chunk_t *chunk = moocore_malloc(1, size, __FILE__, __LINE__);
+        chunk->next = pool->chunks;
+        pool->chunks = chunk;
+        pool->cur = (char *) chunk + header;
+        pool->end = pool->cur + pool->objsize * pool->chunk_nobjs;
+        // Grow geometrically, up to 1 MiB per chunk.
+        if (pool->objsize * pool->chunk_nobjs < (1 << 20))
+            pool->chunk_nobjs *= 2;
+    }
+    void *p = pool->cur;
+    pool->cur += pool->objsize;
+    return p;
+}
+
+static inline void
+pool_free(pool_t *pool, void *p)
+{
+    *(void **) p = pool->free_list;
+    pool->free_list = p;
+}
+
+#endif /* !MOOCORE_POOL_H_ */
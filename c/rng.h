@@ -12,6 +12,16 @@ rng_new(uint32_t seed)
     return rng;
 }
 
+/* Seed RNG with the substream STREAM of SEED.  Each (SEED, STREAM) pair gives
+   a different sequence, so independent tasks (e.g., threads) can draw
+   reproducible random numbers without sharing state.  */
+static inline void
+rng_seed_stream(rng_state * rng, uint32_t seed, uint32_t stream)
+{
+    uint32_t key[2] = { seed, stream };
+    mt19937_init_by_array(rng, key, 2);
+}
+
 static inline void
 rng_free(rng_state * rng)
 {
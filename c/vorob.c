@@ -0,0 +1,93 @@
+#include <string.h>
+#include "eaf.h"
+#include "hv.h"
+
+static double
+avg_hypervolume(const double *data, int nobj, const int *cumsizes, int nruns,
+                const double *ref)
+{
+    double sum = 0;
+    for (int k = 0, start = 0; k < nruns; start = cumsizes[k], k++)
+        sum += fpli_hv(data + (size_t) start * nobj, nobj, cumsizes[k] - start, ref);
+    return sum / nruns;
+}
+
+/* Vorob'ev threshold and expectation.
+
+   The threshold is found by bisection over the percentiles, as in the R
+   version, but all attainment levels are computed by a single call to
+   attsurf() and the hypervolume of each level is computed once, the first
+   time that the bisection visits it.  Returns the points of the Vorob'ev
+   expectation, which the caller must free.
+*/
+double *
+vorob_t(int *ve_npoints, double *threshold, double *avg_hyp,
+        const double *data, int nobj, const int *cumsizes, int nruns,
+        const double *ref)
+{
+    const double avg = avg_hypervolume(data, nobj, cumsizes, nruns, ref);
+
+    int *level = levels_from_percentiles(NULL, nruns, nruns);
+    eaf_t **eaf = attsurf(data, nobj, cumsizes, nruns, level, nruns, 1);
+    free (level);
+
+    double *level_hv = malloc(sizeof(double) * nruns);
+    for (int k = 0; k < nruns; k++)
+        level_hv[k] = NAN;
+
+    double a = 0, b = 100, c, diff;
+    double prev_hyp = INFINITY; // hypervolume of quantile at previous step
+    int k;
+    do {
+        c = (a + b) / 2.0;
+        k = percentile2level(c, nruns) - 1;
+        if (isnan(level_hv[k]))
+            level_hv[k] = fpli_hv(eaf[k]->data, nobj, (int) eaf[k]->size, ref);
+        const double tmp = level_hv[k];
+        if (tmp > avg)
+            a = c;
+        else
+            b = c;
+        diff = prev_hyp - tmp;
+        prev_hyp = tmp;
+    } while (diff != 0);
+    free (level_hv);
+
+    const size_t size = eaf[k]->size;
+    double *ve = malloc(sizeof(double) * size * nobj);
+    memcpy(ve, eaf[k]->data, sizeof(double) * size * nobj);
+    eaf_free(eaf, nruns);
+
+    *ve_npoints = (int) size;
+    *threshold = c;
+    *avg_hyp = avg;
+    return ve;
+}
+
+/* Vorob'ev deviation of the sets in DATA with respect to the Vorob'ev
+   expectation VE, that is, the average hypervolume of the symmetric
+   difference between each set and VE: 2 * H(A U VE) - H(A) - H(VE).  */
+double
+vorob_dev(const double *data, int nobj, const int *cumsizes, int nruns,
+          const double *ve, int ve_npoints, const double *ref)
+{
+    int maxsize = cumsizes[0];
+    for (int k = 1; k < nruns; k++)
+        maxsize = MAX(maxsize, cumsizes[k] - cumsizes[k - 1]);
+    double *buf = malloc(sizeof(double) * ((size_t) maxsize + ve_npoints) * nobj);
+    /* VE goes first, so that only the points of each set need to be copied.  */
+    memcpy(buf, ve, sizeof(double) * ve_npoints * nobj);
+    double *set = buf + (size_t) ve_npoints * nobj;
+
+    double h1 = 0, hunion = 0;
+    for (int k = 0, start = 0; k < nruns; start = cumsizes[k], k++) {
+        const int size = cumsizes[k] - start;
+        const double *x = data + (size_t) start * nobj;
+        h1 += fpli_hv(x, nobj, size, ref);
+        memcpy(set, x, sizeof(double) * size * nobj);
+        hunion += fpli_hv(buf, nobj, ve_npoints + size, ref);
+    }
+    free (buf);
+    const double h2 = fpli_hv(ve, nobj, ve_npoints, ref);
+    return 2 * (hunion / nruns) - h1 / nruns - h2;
+}
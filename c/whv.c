@@ -3,6 +3,7 @@
 #define DEBUG 1
 #include "common.h"
 #include <float.h>
+#include <string.h>
 
 static int cmp_data_y_desc (const void *p1, const void *p2)
 {
@@ -25,54 +26,36 @@ static int cmp_rectangles_y_desc (const void *p1, const void *p2)
         : 0;
 }
 
+/* Return a copy of RECTANGLES clipped to REFERENCE without the rectangles
+   that become empty, or NULL if none remains.  */
 static double *
-whv_preprocess_rectangles(double * rectangles, int nrow,
+whv_preprocess_rectangles(const double * rectangles, int nrow,
                           const double *reference, int *new_nrow_p)
 {
     const int ncol = 5;
+    double *dest = malloc(sizeof(double) * ncol * nrow);
+    int j = 0;
     for (int k = 0; k < nrow; k++) {
-        rectangles[k * ncol + 0] = MIN(rectangles[k * ncol + 0], reference[0]);
-        rectangles[k * ncol + 1] = MIN(rectangles[k * ncol + 1], reference[1]);
-        rectangles[k * ncol + 2] = MIN(rectangles[k * ncol + 2], reference[0]);
-        rectangles[k * ncol + 3] = MIN(rectangles[k * ncol + 3], reference[1]);
+        const double *src = rectangles + k * ncol;
+        double *rect = dest + j * ncol;
+        rect[0] = MIN(src[0], reference[0]);
+        rect[1] = MIN(src[1], reference[1]);
+        rect[2] = MIN(src[2], reference[0]);
+        rect[3] = MIN(src[3], reference[1]);
+        rect[4] = src[4];
+        if (rect[0] != rect[2] && rect[1] != rect[3])
+            j++;
     }
-    int * skip = malloc(nrow * sizeof(int));
-    int skip_nrow = 0;
-    for (int k = 0; k < nrow; k++) {
-        if (rectangles[k * ncol + 0] == rectangles[k * ncol + 2]
-            || rectangles[k * ncol + 1] == rectangles[k * ncol + 3])
-            skip[skip_nrow++] = k;
-    }
-
-    if (skip_nrow == 0) {
-        free(skip);
-        *new_nrow_p = nrow;
-        return rectangles;
-    }
-    int new_nrow = nrow - skip_nrow;
-    if (new_nrow == 0) {
-        free(skip);
-        *new_nrow_p = 0;
+    *new_nrow_p = j;
+    if (j == 0) {
+        free(dest);
         return NULL;
     }
-    double *dest = malloc(sizeof(double) * 5 * new_nrow);
-    skip[skip_nrow] = nrow;
-    int j = 0, k = 0;
-    for (int s = 0; s <= skip_nrow; s++) {
-        while (k < skip[s]) {
-            for (int c = 0; c < 5; c++)
-                dest[j * ncol + c] = rectangles[k * ncol + c];
-            k++, j++;
-        }
-        k = skip[s] + 1;
-    }
-    free(skip);
-    *new_nrow_p = new_nrow;
     return dest;
 }
 
 double
-rect_weighted_hv2d(double *data, int n, double * rectangles,
+rect_weighted_hv2d(const double *points, int n, const double *input_rectangles,
                    int rectangles_nrow, const double * reference)
 {
 #define print_point(k, p, r, rect)                                             \
@@ -108,13 +91,15 @@ rect_weighted_hv2d(double *data, int n, double * rectangles,
     DEBUG2_PRINT("n = %lu\trectangles = %lu\n", (unsigned long)n, (unsigned long)rectangles_nrow);
     if (rectangles_nrow <= 0 || n <= 0) return 0;
 
-    int old_rectangles_nrow = rectangles_nrow;
-    rectangles =
-        whv_preprocess_rectangles(rectangles, old_rectangles_nrow, reference, &rectangles_nrow);
+    /* The points and rectangles are sorted, so work on copies of them.  */
+    double *rectangles =
+        whv_preprocess_rectangles(input_rectangles, rectangles_nrow, reference, &rectangles_nrow);
     if (rectangles_nrow == 0)
         return 0;
 
     const int nobj = 2;
+    double *data = malloc(sizeof(double) * nobj * n);
+    memcpy(data, points, sizeof(double) * nobj * n);
     qsort (data, n, 2 * sizeof(*data), &cmp_data_y_desc);
     qsort (rectangles, rectangles_nrow, (nobj * 2 + 1) * sizeof(*rectangles),
            &cmp_rectangles_y_desc);
@@ -173,9 +158,58 @@ rect_weighted_hv2d(double *data, int n, double * rectangles,
         } while (top == p[1] && p[1] >= upper1);
     }
 return_whv:
-    if (old_rectangles_nrow != rectangles_nrow)
-        free (rectangles);
+    free (data);
+    free (rectangles);
+
+    DEBUG2_PRINT("whv: %16.15g\n", whv);
+    return whv;
+}
 
+double hv3d_plus(const double * restrict data, size_t n, const double * restrict ref);
+
+/* Exact weighted hypervolume of DATA (3D) where the weights are given by
+   axis-aligned boxes: lower corner, upper corner and color (weight) per row.
+
+   The weighted hypervolume is the sum over boxes of the color times the
+   volume of the region dominated by DATA within the box and below
+   REFERENCE. That volume is the hypervolume of the points of DATA that
+   strictly dominate the (clipped) upper corner of the box, raised to its
+   lower corner, with respect to the upper corner. Overlapping boxes add up
+   their colors.  */
+double
+rect_weighted_hv3d(const double *data, int n, const double *rectangles,
+                   int rectangles_nrow, const double *reference)
+{
+    const int nobj = 3;
+    const int ncol = 2 * nobj + 1;
+    if (rectangles_nrow <= 0 || n <= 0) return 0;
+
+    double *points = malloc(sizeof(double) * nobj * n);
+    double whv = 0.0;
+    for (int r = 0; r < rectangles_nrow; r++) {
+        const double *lower = rectangles + r * ncol;
+        const double color = lower[ncol - 1];
+        double upper[3];
+        bool empty = (color == 0);
+        for (int k = 0; k < nobj; k++) {
+            upper[k] = MIN(lower[nobj + k], reference[k]);
+            empty = empty || (upper[k] <= lower[k]);
+        }
+        if (empty) continue;
+
+        size_t m = 0;
+        for (int i = 0; i < n; i++) {
+            const double *p = data + i * nobj;
+            if (p[0] < upper[0] && p[1] < upper[1] && p[2] < upper[2]) {
+                for (int k = 0; k < nobj; k++)
+                    points[m * nobj + k] = MAX(p[k], lower[k]);
+                m++;
+            }
+        }
+        if (m > 0)
+            whv += color * hv3d_plus(points, m, upper);
+    }
+    free(points);
     DEBUG2_PRINT("whv: %16.15g\n", whv);
     return whv;
 }
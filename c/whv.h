@@ -1,4 +1,5 @@
 #ifndef WHV_H
 #define WHV_H
-double rect_weighted_hv2d(double *data, int n, double * rectangles, int  rectangles_nrow, const double *reference);
+double rect_weighted_hv2d(const double *data, int n, const double *rectangles, int rectangles_nrow, const double *reference);
+double rect_weighted_hv3d(const double *data, int n, const double *rectangles, int rectangles_nrow, const double *reference);
 #endif // WHV_H
@@ -15,6 +15,7 @@ typedef double *(*hype_sample_fn)(hype_sample_dist *, int);
 
 struct hype_sample_dist {
     enum hype_sample_dist_type type;
+    int nobj;
     rng_state * rng;
     double * lower;
     double * range;
@@ -79,7 +80,7 @@ exp_dist_sample(hype_sample_dist * dist, int nsamples)
 static double *
 uniform_dist_sample(hype_sample_dist * dist, int nsamples)
 {
-    const int nobj = 2;
+    const int nobj = dist->nobj;
     const double *lower = dist->lower;
     const double *range = dist->range;
     rng_state * rng = dist->rng;
@@ -94,11 +95,11 @@ uniform_dist_sample(hype_sample_dist * dist, int nsamples)
 }
 
 static hype_sample_dist *
-hype_dist_new(uint32_t seed)
+hype_dist_new(uint32_t seed, int nobj)
 {
     hype_sample_dist * dist = malloc(sizeof(hype_sample_dist));
+    dist->nobj = nobj;
     dist->rng = rng_new(seed);
-    const int nobj = 2;
     dist->lower = malloc(sizeof(double) * nobj);
     dist->range = malloc(sizeof(double) * nobj);
     for (int i = 0; i < nobj; i++) {
@@ -112,7 +113,7 @@ hype_dist_new(uint32_t seed)
 static hype_sample_dist *
 hype_dist_gaussian_new(uint32_t seed, const double *mu)
 {
-    hype_sample_dist *dist = hype_dist_new(seed);
+    hype_sample_dist *dist = hype_dist_new(seed, 2);
     dist->type = HYPE_DIST_GAUSSIAN;
     const int nobj = 2;
     dist->mu = malloc(sizeof(double) * nobj);
@@ -124,7 +125,7 @@ hype_dist_gaussian_new(uint32_t seed, const double *mu)
 static hype_sample_dist *
 hype_dist_exp_new(uint32_t seed, double mu)
 {
-    hype_sample_dist *dist = hype_dist_new(seed);
+    hype_sample_dist *dist = hype_dist_new(seed, 2);
     dist->type = HYPE_DIST_EXPONENTIAL;
     dist->mu = malloc(sizeof(double) * 1);
     dist->mu[0] = mu;
@@ -133,9 +134,9 @@ hype_dist_exp_new(uint32_t seed, double mu)
 }
 
 static hype_sample_dist *
-hype_dist_unif_new(uint32_t seed)
+hype_dist_unif_new(uint32_t seed, int nobj)
 {
-    hype_sample_dist *dist = hype_dist_new(seed);
+    hype_sample_dist *dist = hype_dist_new(seed, nobj);
     dist->type = HYPE_DIST_UNIFORM;
     dist->create_samples = uniform_dist_sample;
     return dist;
@@ -151,48 +152,110 @@ hype_dist_free(hype_sample_dist * d)
     free(d);
 }
 
-static double
-estimate_whv(const double *points, int npoints,
-             const double * samples, int nsamples)
+/* Number of samples weakly dominated by at least one point in 2D.  The
+   points are sorted by y and reduced to a staircase of decreasing x, then
+   each sample is located in the staircase by binary search.  */
+static size_t
+count_dominated_2d(const double *points, int npoints,
+                   const double *samples, int nsamples)
 {
     const int nobj = 2;
-    /* // compute alpha factor of HypE fitness: */
-    /* double * alpha = malloc(npoints * sizeof(double)); */
-    /* for (int i = 1; i <= npoints; i++) { */
-    /*     alpha[i - 1] = 1.0 / i; */
-    /* } */
-    double whv = 0.0;
-    // compute amount of dominators in p for each sample:
-    unsigned int * dominated = calloc(nsamples, sizeof(unsigned int));
-    bool * is_dominator = malloc(npoints * sizeof(bool));
+    const double **p = generate_sorted_pp_2d(points, npoints);
+    double *x = malloc(sizeof(double) * npoints);
+    double *y = malloc(sizeof(double) * npoints);
+    int n = 0;
+    for (int j = 0; j < npoints; j++) {
+        // Points with equal y are sorted by x, so only the first one is kept.
+        if (n > 0 && p[j][0] >= x[n - 1])
+            continue;
+        x[n] = p[j][0];
+        y[n] = p[j][1];
+        n++;
+    }
+    free(p);
+
+    size_t count = 0;
     for (int s = 0; s < nsamples; s++) {
         const double *sample = samples + s * nobj;
-        // compute amount of dominators in p for each sample:
-        for (int j = 0; j < npoints; j++) {
-            bool dom = true;
-            const double *p = points + j * nobj;
-            for (int d = 0; d < nobj; d++) {
-                if (sample[d] < p[d]) {
-                    dom = false;
-                    break;
-                }
-            }
-            if (dom) dominated[s]++;
-            is_dominator[j] = dom;
+        // Find the last point with y <= sample[1], which has the lowest x.
+        int lo = 0, hi = n;
+        while (lo < hi) {
+            int mid = lo + (hi - lo) / 2;
+            if (y[mid] <= sample[1])
+                lo = mid + 1;
+            else
+                hi = mid;
+        }
+        count += (lo > 0 && x[lo - 1] <= sample[0]);
+    }
+    free(x);
+    free(y);
+    return count;
+}
+
+#define HYPE_BLOCK_SIZE 64
+
+/* Number of samples weakly dominated by at least one point, for any number
+   of objectives.  The points are stored by blocks of HYPE_BLOCK_SIZE in
+   structure-of-arrays layout so that the dominance test of a sample against
+   a block does not branch and can be vectorized.  The last block is padded
+   with points that dominate nothing.  */
+static size_t
+count_dominated_nd(const double *points, int npoints, int nobj,
+                   const double *samples, int nsamples)
+{
+    const int nblocks = (npoints + HYPE_BLOCK_SIZE - 1) / HYPE_BLOCK_SIZE;
+    double *soa = malloc(sizeof(double) * nblocks * nobj * HYPE_BLOCK_SIZE);
+    for (int b = 0; b < nblocks; b++) {
+        double *block = soa + b * nobj * HYPE_BLOCK_SIZE;
+        for (int j = 0; j < HYPE_BLOCK_SIZE; j++) {
+            const int k = b * HYPE_BLOCK_SIZE + j;
+            for (int d = 0; d < nobj; d++)
+                block[d * HYPE_BLOCK_SIZE + j] =
+                    (k < npoints) ? points[k * nobj + d] : INFINITY;
         }
-        // sum up alpha values of each dominated sample:
-        for (int j = 0; j < npoints; j++) {
-            if (is_dominator[j]) {
-                assert(dominated[s] > 0);
-                whv += 1.0 / dominated[s];
-                //fprintf(stderr, "whv = %g\n", whv);
+    }
+
+    size_t count = 0;
+    for (int s = 0; s < nsamples; s++) {
+        const double *sample = samples + s * nobj;
+        for (int b = 0; b < nblocks; b++) {
+            const double *block = soa + b * nobj * HYPE_BLOCK_SIZE;
+            unsigned char dom[HYPE_BLOCK_SIZE];
+            for (int j = 0; j < HYPE_BLOCK_SIZE; j++)
+                dom[j] = block[j] <= sample[0];
+            for (int d = 1; d < nobj; d++) {
+                const double *coord = block + d * HYPE_BLOCK_SIZE;
+                for (int j = 0; j < HYPE_BLOCK_SIZE; j++)
+                    dom[j] &= coord[j] <= sample[d];
+            }
+            unsigned char any = 0;
+            for (int j = 0; j < HYPE_BLOCK_SIZE; j++)
+                any |= dom[j];
+            if (any) {
+                count++;
+                break;
             }
         }
     }
-    free(dominated);
-    free(is_dominator);
-    //free(alpha);
-    return whv;
+    free(soa);
+    return count;
+}
+
+/* HypE estimate of the weighted hypervolume (Eq. 18 without the volume
+   factor).  Each sample dominated by k points adds alpha = 1/k for each of
+   them, that is, exactly 1, thus the estimate is the number of dominated
+   samples.  */
+static double
+estimate_whv(const double *points, int npoints, int nobj,
+             const double * samples, int nsamples)
+{
+    if (npoints == 0)
+        return 0.0;
+    size_t count = (nobj == 2)
+        ? count_dominated_2d(points, npoints, samples, nsamples)
+        : count_dominated_nd(points, npoints, nobj, samples, nsamples);
+    return (double) count;
 }
 
 static double
@@ -230,10 +293,10 @@ whv_hype_sample(const double *points, int npoints,
                 const double *ideal, const double *ref,
                 int nsamples, hype_sample_dist * dist)
 {
-    const int nobj = 2;
+    const int nobj = dist->nobj;
     const double * samples = dist->create_samples(dist, nsamples);
     const double * points2 = normalise01(points, nobj, npoints, ideal, ref);
-    double whv = estimate_whv(points2, npoints, samples, nsamples);
+    double whv = estimate_whv(points2, npoints, nobj, samples, nsamples);
     free((void *)samples);
     free((void *)points2);
     /* Eq 18 */
@@ -258,11 +321,11 @@ whv_hype_estimate(const double *points, int npoints,
 }
 
 double
-whv_hype_unif(const double *points, int npoints,
+whv_hype_unif(const double *points, int npoints, int nobj,
               const double *ideal, const double *ref,
               int nsamples, uint32_t seed)
 {
-    hype_sample_dist * dist = hype_dist_unif_new(seed);
+    hype_sample_dist * dist = hype_dist_unif_new(seed, nobj);
     double whv = whv_hype_sample(points, npoints, ideal, ref, nsamples, dist);
     hype_dist_free(dist);
     return whv;
@@ -2,7 +2,7 @@
 #define WHV_HYPE_H
 #include <stdint.h>
 
-double whv_hype_unif(const double *points, int npoints,
+double whv_hype_unif(const double *points, int npoints, int nobj,
                      const double *ideal, const double *ref,
                      int nsamples, uint32_t seed);
 double whv_hype_expo(const double *points, int npoints,
@@ -4,5 +4,6 @@ import moocore
 
 
 @pytest.fixture(autouse=True)
-def add_doctest_imports(doctest_namespace) -> None:
+def add_doctest_imports(doctest_namespace, tmp_path) -> None:
     doctest_namespace["moocore"] = moocore
+    doctest_namespace["tmp_path"] = tmp_path
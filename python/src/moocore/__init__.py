@@ -12,7 +12,9 @@ from ._moocore import (
     filter_dominated,
     filter_dominated_within_sets,
     hv_approx,
+    hv_approx_adaptive,
     hv_contributions,
+    hvc_approx,
     hypervolume,
     igd,
     igd_plus,
@@ -22,11 +24,14 @@ from ._moocore import (
     normalise,
     pareto_rank,
     read_datasets,
+    read_datasets_binary,
     total_whv_rect,
     vorob_dev,
     vorob_t,
+    whv_eafdiff,
     whv_hype,
     whv_rect,
+    write_datasets_binary,
 )
 
 from ._datasets import (
@@ -56,7 +61,9 @@ __all__ = [
     "get_dataset",
     "get_dataset_path",
     "hv_approx",
+    "hv_approx_adaptive",
     "hv_contributions",
+    "hvc_approx",
     "hypervolume",
     "igd",
     "igd_plus",
@@ -66,9 +73,12 @@ __all__ = [
     "normalise",
     "pareto_rank",
     "read_datasets",
+    "read_datasets_binary",
     "total_whv_rect",
     "vorob_dev",
     "vorob_t",
+    "whv_eafdiff",
     "whv_hype",
     "whv_rect",
+    "write_datasets_binary",
 ]
@@ -29,6 +29,7 @@ sources = [
     "avl.c",
     "eaf.c",
     "eaf3d.c",
+    "eafnd.c",
     "eafdiff.c",
     "hv.c",
     "hvapprox.c",
@@ -40,6 +41,7 @@ sources = [
     "mt19937/mt19937.c",
     "pareto.c",
     "rng.c",
+    "vorob.c",
     "whv.c",
     "whv_hype.c",
 ]
@@ -88,6 +90,12 @@ if is_windows and uses_msvc():
 else:
     extra_compile_args.extend(GCC_CFLAGS)
     extra_link_args.extend(GCC_CFLAGS)
+    # OpenMP is optional, as in the C Makefile (disable with MOOCORE_OPENMP=0).
+    if (
+        platform.system() == "Linux"
+        and os.environ.get("MOOCORE_OPENMP", "1") != "0"
+    ):
+        extra_compile_args.append("-fopenmp")
     target_platform = _get_target_platform(
         os.environ.get("ARCHFLAGS", ""), platform.machine()
     )
@@ -9,9 +9,12 @@ from typing import Literal, Any
 # NOTE: if we ever start using SciPy, we can use
 # from scipy.special import gamma_function
 
+import gzip
 import lzma
 import shutil
+import struct
 import tempfile
+from statistics import NormalDist
 
 import numpy as np
 
@@ -23,6 +26,7 @@ from ._utils import (
     np1d_to_int_array,
     atleast_1d_of_length_n,
     is_integer_value,
+    get_nthreads,
 )
 
 ## The CFFI library is used to create C bindings.
@@ -54,7 +58,9 @@ class ReadDatasetsError(Exception):
         super().__init__(self.message)
 
 
-def read_datasets(filename: str | os.PathLike | StringIO) -> np.ndarray:
+def read_datasets(
+    filename: str | os.PathLike | StringIO, *, nthreads: int | None = None
+) -> np.ndarray:
     """Read an input dataset file, parsing the file and returning a numpy array.
 
     Parameters
@@ -62,8 +68,12 @@ def read_datasets(filename: str | os.PathLike | StringIO) -> np.ndarray:
     filename:
         Filename of the dataset file or :class:`io.StringIO` directly containing the file contents.
         If it does not contain an absolute path, the filename is relative to the current working directory.
-        If the filename has extension ``.xz``, it is decompressed to a temporary file before reading it.
+        If the filename has extension ``.gz`` or ``.xz``, it is decompressed to a temporary file before reading it.
         Each line of the file corresponds to one point of one dataset. Different datasets are separated by an empty line.
+    nthreads :
+        Maximum number of threads used by this call.  ``None`` uses the
+        environment variable ``OMP_NUM_THREADS``, if set, otherwise the number
+        of CPUs available to the process.
 
     Returns
     -------
@@ -111,21 +121,23 @@ def read_datasets(filename: str | os.PathLike | StringIO) -> np.ndarray:
            [0.5, 0.5, 3. ]])
 
     """  # noqa: D301
+    nthreads = get_nthreads(nthreads)
     if isinstance(filename, os.PathLike):
         filename = os.fspath(filename)
     elif isinstance(filename, StringIO):
         with tempfile.NamedTemporaryFile(mode="wt", delete=False) as fdst:
             shutil.copyfileobj(filename, fdst)
         # FIXME: Avoid recursion
-        return read_datasets(fdst.name)
+        return read_datasets(fdst.name, nthreads=nthreads)
     else:
         filename = os.path.expanduser(filename)
 
     if not os.path.isfile(filename):
         raise FileNotFoundError(f"file '{filename}' not found")
 
-    if filename.endswith(".xz"):
-        with lzma.open(filename, "rb") as fsrc:
+    if filename.endswith((".gz", ".xz")):
+        opener = gzip.open if filename.endswith(".gz") else lzma.open
+        with opener(filename, "rb") as fsrc:
             with tempfile.NamedTemporaryFile(delete=False) as fdst:
                 shutil.copyfileobj(fsrc, fdst)
         filename = fdst.name
@@ -138,7 +150,9 @@ def read_datasets(filename: str | os.PathLike | StringIO) -> np.ndarray:
     data_p = ffi.new("double **")
     ncols_p = ffi.new("int *")
     datasize_p = ffi.new("int *")
-    err_code = lib.read_datasets(filename, data_p, ncols_p, datasize_p)
+    err_code = lib.read_datasets(
+        filename, data_p, ncols_p, datasize_p, nthreads
+    )
     if fdst:
         os.remove(fdst.name)
     if err_code != 0:
@@ -150,6 +164,167 @@ def read_datasets(filename: str | os.PathLike | StringIO) -> np.ndarray:
     return np.frombuffer(data_buf).reshape((-1, ncols_p[0]))
 
 
+# Header of the binary format documented in libmoocore/io.h.
+_BINARY_MAGIC = b"MOODATA1"
+_BINARY_HEADER = "8sIIIIQ"
+_BINARY_BYTE_ORDER_MARK = 0x01020304
+_BINARY_DATA_ALIGNMENT = 64
+_BINARY_DTYPES = {1: np.float64, 2: np.intc}
+_INT_MAX = np.iinfo(np.intc).max
+
+
+def write_datasets_binary(
+    filename: str | os.PathLike, data: ArrayLike, /, sets: ArrayLike
+) -> None:
+    """Write datasets to a file in the binary format of moocore.
+
+    Files in this format can be read much faster than text files by
+    :func:`read_datasets` and the command-line tools, and they can be
+    memory-mapped by :func:`read_datasets_binary`.  Values are stored in the
+    byte order of the current machine, thus the file cannot be read by a
+    machine with a different byte order.
+
+    Parameters
+    ----------
+    filename:
+        Filename of the output file. It is overwritten if it exists.
+    data:
+        Array of numerical values, where each row gives the coordinates of a point in objective space.
+        If the array is created by the :func:`read_datasets()` function, remove the last column.
+    sets:
+        1D vector or list of values that define the sets to which each row of ``data`` belongs.
+        The points are stored grouped by set in increasing order of ``sets``.
+
+    See Also
+    --------
+    read_datasets_binary : read a file in binary format as a memory map.
+
+    Examples
+    --------
+    >>> x = moocore.get_dataset("input1.dat")
+    >>> filename = tmp_path / "input1.bin"
+    >>> moocore.write_datasets_binary(filename, x[:, :-1], x[:, -1])
+    >>> np.array_equal(moocore.read_datasets(filename), x)
+    True
+
+    """
+    data = np.asarray(data, dtype=float)
+    if data.ndim != 2 or data.shape[1] < 1:
+        raise ValueError("'data' must be a 2D array")
+    sets = np.asarray(sets)
+    if len(sets) != data.shape[0]:
+        raise ValueError(
+            "'sets' must have the same length as the number of rows of 'data'"
+        )
+    order = np.argsort(sets, kind="stable")
+    _, cumsizes = np.unique(sets[order], return_counts=True)
+    cumsizes = np.cumsum(cumsizes, dtype=np.int32)
+    header = struct.pack(
+        _BINARY_HEADER,
+        _BINARY_MAGIC,
+        _BINARY_BYTE_ORDER_MARK,
+        1,
+        data.shape[1],
+        len(cumsizes),
+        data.shape[0],
+    )
+    header += cumsizes.tobytes()
+    header += bytes(-len(header) % _BINARY_DATA_ALIGNMENT)
+    with open(filename, "wb") as f:
+        f.write(header)
+        f.write(np.ascontiguousarray(data[order]).tobytes())
+
+
+def read_datasets_binary(
+    filename: str | os.PathLike, mmap_mode: Literal["r", "r+", "c"] = "r"
+) -> tuple[np.ndarray, np.ndarray]:
+    """Read a file in the binary format of moocore as a memory map.
+
+    The data is not read into memory, thus, the file can be much larger than
+    the available memory.  Files written by :func:`write_datasets_binary` or
+    by ``nondominated --binary`` may be read with this function or with
+    :func:`read_datasets`.
+
+    Parameters
+    ----------
+    filename:
+        Filename of the dataset file in binary format.
+    mmap_mode:
+        Mode of the memory map, see :class:`numpy.memmap`.
+
+    Returns
+    -------
+        A tuple ``(data, sets)``, where ``data`` is a :class:`numpy.memmap`
+        with one row per point and one column per objective, and ``sets`` is
+        a 1D array that gives the set (starting at 1) of each row of ``data``.
+
+    Raises
+    ------
+    ReadDatasetsError
+        If the file is empty, it is not in binary format or it was written by
+        a machine with a different byte order.
+
+    See Also
+    --------
+    write_datasets_binary : write a file in binary format.
+
+    Examples
+    --------
+    >>> x = moocore.get_dataset("input1.dat")
+    >>> filename = tmp_path / "input1.bin"
+    >>> moocore.write_datasets_binary(filename, x[:, :-1], x[:, -1])
+    >>> data, sets = moocore.read_datasets_binary(filename)
+    >>> data.shape
+    (100, 2)
+    >>> np.unique(sets, return_counts=True)[1]
+    array([10, 10, 10, 10, 10, 10, 10, 10, 10, 10])
+
+    """
+    filename = os.path.expanduser(os.fspath(filename))
+    if not os.path.isfile(filename):
+        raise FileNotFoundError(f"file '{filename}' not found")
+
+    header_size = struct.calcsize(_BINARY_HEADER)
+    with open(filename, "rb") as f:
+        header = f.read(header_size)
+        if len(header) < header_size or not header.startswith(_BINARY_MAGIC):
+            raise ReadDatasetsError(-4)
+        magic, bom, dtype, nobj, nsets, npoints = struct.unpack(
+            "=" + _BINARY_HEADER, header
+        )
+        # The same checks as the C reader, which also rejects files written
+        # by a machine with a different byte order.
+        if (
+            bom != _BINARY_BYTE_ORDER_MARK
+            or dtype not in _BINARY_DTYPES
+            or nobj == 0
+            or max(nobj, nsets, npoints) > _INT_MAX
+            or (npoints == 0) != (nsets == 0)
+        ):
+            raise ReadDatasetsError(-4)
+        if npoints == 0:
+            raise ReadDatasetsError(-1)
+        cumsizes = np.fromfile(f, dtype=np.int32, count=nsets)
+    if (
+        len(cumsizes) != nsets
+        or cumsizes[-1] != npoints
+        or np.any(np.diff(cumsizes, prepend=0) <= 0)
+    ):
+        raise ReadDatasetsError(-4)
+
+    offset = header_size + 4 * nsets
+    offset += -offset % _BINARY_DATA_ALIGNMENT
+    data = np.memmap(
+        filename,
+        dtype=_BINARY_DTYPES[dtype],
+        mode=mmap_mode,
+        offset=offset,
+        shape=(npoints, nobj),
+    )
+    sets = np.repeat(np.arange(1, nsets + 1), np.diff(cumsizes, prepend=0))
+    return data, sets
+
+
 def _parse_maximise(maximise, nobj: int):
     """Convert maximise array or single bool to ndarray format."""
     return atleast_1d_of_length_n(maximise, nobj).astype(bool)
@@ -760,6 +935,7 @@ def hv_approx(
     nsamples: int = 100_000,
     seed: int | np.random.Generator | None = None,
     method: Literal["DZ2019-HW", "DZ2019-MC"] = "DZ2019-HW",
+    nthreads: int | None = None,
 ) -> float:
     r"""Approximate the hypervolume indicator.
 
@@ -796,6 +972,10 @@ def hv_approx(
         (see :func:`numpy.random.default_rng`).
     method :
         Method to approximate the hypervolume.
+    nthreads :
+        Maximum number of threads used by this call.  ``None`` uses the
+        environment variable ``OMP_NUM_THREADS``, if set, otherwise the number
+        of CPUs available to the process.
 
     Returns
     -------
@@ -837,7 +1017,7 @@ def hv_approx(
     >>> moocore.hypervolume(x, ref=[10, 10])
     38.0
     >>> moocore.hv_approx(x, ref=[10, 10], seed=42, method="DZ2019-MC")
-    38.01475
+    38.01059
     >>> moocore.hv_approx(x, ref=[10, 10], method="DZ2019-HW")
     37.99989
 
@@ -895,11 +1075,24 @@ def hv_approx(
             )
         seed = ffi.cast("uint32_t", seed)
         hv = lib.hv_approx_normal(
-            data_p, nobj, npoints, ref, maximise, nsamples, seed
+            data_p,
+            nobj,
+            npoints,
+            ref,
+            maximise,
+            nsamples,
+            seed,
+            get_nthreads(nthreads),
         )
     elif method == "DZ2019-HW":
         hv = lib.hv_approx_hua_wang(
-            data_p, nobj, npoints, ref, maximise, nsamples
+            data_p,
+            nobj,
+            npoints,
+            ref,
+            maximise,
+            nsamples,
+            get_nthreads(nthreads),
         )
     else:
         raise ValueError("Unknown value of method = {method}")
@@ -907,6 +1100,238 @@ def hv_approx(
     return hv
 
 
+def hv_approx_adaptive(
+    data: ArrayLike,
+    /,
+    ref: ArrayLike,
+    *,
+    maximise: bool | list[bool] = False,
+    rel_error: float = 1e-3,
+    confidence: float = 0.95,
+    max_nsamples: int = 10_000_000,
+    seed: int | np.random.Generator | None = None,
+    nthreads: int | None = None,
+) -> tuple[float, float, int]:
+    r"""Approximate the hypervolume indicator up to a given relative error.
+
+    Same as :func:`hv_approx` with ``method="DZ2019-MC"``, but instead of
+    using a fixed number of samples, the samples are generated in batches
+    until the half-width of the confidence interval of the estimate, with
+    confidence level ``confidence``, is at most ``rel_error`` times the
+    estimate, or ``max_nsamples`` samples have been generated. Easy inputs
+    need fewer samples than hard ones.
+
+    Parameters
+    ----------
+    data :
+        Numpy array of numerical values, where each row gives the coordinates of a point in objective space.
+        If the array is created from the :func:`read_datasets` function, remove the last (set) column.
+    ref :
+        Reference point as a 1D vector. Must be same length as a single point in ``data``.
+    maximise :
+        Whether the objectives must be maximised instead of minimised.
+        Either a single boolean value that applies to all objectives or a list of booleans, with one value per objective.
+        Also accepts a 1D numpy array with value 0/1 for each objective.
+    rel_error :
+        Requested relative error of the estimate.
+    confidence :
+        Confidence level of the interval, between 0 and 1.
+    max_nsamples :
+        Maximum number of samples, a positive integer smaller than ``2**32``.
+    seed :
+        Either an integer to seed :func:`numpy.random.default_rng`, Numpy
+        default random number generator (RNG) or an instance of a
+        Numpy-compatible RNG. ``None`` uses the equivalent of a random seed
+        (see :func:`numpy.random.default_rng`).
+    nthreads :
+        Maximum number of threads used by this call. See :func:`hv_approx`.
+
+    Returns
+    -------
+        A tuple with the estimate of the hypervolume, its standard error and
+        the number of samples used. The estimate is the same as
+        :func:`hv_approx` with ``method="DZ2019-MC"``, the same ``seed`` and
+        ``nsamples`` equal to the number of samples used, up to rounding.
+
+    See Also
+    --------
+    hv_approx
+
+    Examples
+    --------
+    >>> x = np.array([[5, 5], [4, 6], [2, 7], [7, 4]])
+    >>> moocore.hypervolume(x, ref=[10, 10])
+    38.0
+    >>> hv, std_error, nsamples = moocore.hv_approx_adaptive(
+    ...     x, ref=[10, 10], rel_error=1e-3, seed=42
+    ... )
+    >>> round(hv, 1), nsamples
+    (38.0, 262144)
+
+    """
+    data, _ = asarray_maybe_copy(data)
+    nobj = data.shape[1]
+    ref = atleast_1d_of_length_n(np.array(ref, dtype=float), nobj)
+    if nobj != ref.shape[0]:
+        raise ValueError(
+            f"data and ref need to have the same number of objectives ({nobj} != {ref.shape[0]})"
+        )
+    if not 0 < confidence < 1:
+        raise ValueError(f"confidence must be within (0, 1): {confidence}")
+    if not rel_error > 0:
+        raise ValueError(f"rel_error must be positive: {rel_error}")
+    if not is_integer_value(max_nsamples):
+        raise ValueError(
+            f"max_nsamples must be an integer value: {max_nsamples}"
+        )
+    if not 0 < max_nsamples < 2**32:
+        raise ValueError(
+            f"max_nsamples must be within (0, 2**32): {max_nsamples}"
+        )
+
+    maximise = _parse_maximise(maximise, nobj)
+    maximise = ffi.from_buffer("bool []", maximise)
+    data_p, npoints, nobj = np2d_to_double_array(data)
+    ref = ffi.from_buffer("double []", ref)
+    if not is_integer_value(seed):
+        seed = np.random.default_rng(seed).integers(2**32 - 2, dtype=np.uint32)
+
+    z = NormalDist().inv_cdf(0.5 + confidence / 2)
+    std_error = ffi.new("double *")
+    nsamples = ffi.new("uint_fast32_t *")
+    hv = lib.hv_approx_normal_adaptive(
+        std_error,
+        nsamples,
+        data_p,
+        nobj,
+        npoints,
+        ref,
+        maximise,
+        rel_error,
+        z,
+        ffi.cast("uint_fast32_t", max_nsamples),
+        ffi.cast("uint32_t", seed),
+        get_nthreads(nthreads),
+    )
+    return hv, std_error[0], nsamples[0]
+
+
+def hvc_approx(
+    data: ArrayLike,
+    /,
+    ref: ArrayLike,
+    *,
+    maximise: bool | list[bool] = False,
+    nsamples: int = 100_000,
+    seed: int | np.random.Generator | None = None,
+    method: Literal["DZ2019-HW", "DZ2019-MC"] = "DZ2019-HW",
+    nthreads: int | None = None,
+) -> np.ndarray:
+    r"""Approximate the hypervolume contributions of a set of points.
+
+    Approximate the value of :func:`hv_contributions` using the same
+    directions as :func:`hv_approx` :footcite:p:`DenZha2019approxhv`. Along
+    each direction :math:`w`, only the point :math:`y` with the largest value
+    of :math:`s(w, y)` (see :func:`hv_approx`) contributes, and its
+    contribution is :math:`s(w, y)^m - s(w, y')^m`, where :math:`y'` has the
+    second largest value. Thus, all contributions are approximated in a single
+    pass, which is useful when the number of objectives is large and
+    :func:`hv_contributions` is too slow.
+
+    Parameters
+    ----------
+    data :
+        Numpy array of numerical values, where each row gives the coordinates of a point in objective space.
+        If the array is created from the :func:`read_datasets` function, remove the last (set) column.
+    ref :
+        Reference point as a 1D vector. Must be same length as a single point in ``data``.
+    maximise :
+        Whether the objectives must be maximised instead of minimised.
+        Either a single boolean value that applies to all objectives or a list of booleans, with one value per objective.
+        Also accepts a 1D numpy array with value 0/1 for each objective.
+    nsamples :
+        Number of directions.
+    seed :
+        Random seed for ``method="DZ2019-MC"``. See :func:`hv_approx`.
+    method :
+        Method to generate the directions. See :func:`hv_approx`.
+    nthreads :
+        Maximum number of threads used by this call. See :func:`hv_approx`.
+
+    Returns
+    -------
+        An array of floating-point values as long as the number of rows in ``data``.
+        Each value is the approximate contribution of the corresponding point in ``data``.
+
+    See Also
+    --------
+    hv_contributions, hv_approx
+
+    References
+    ----------
+    .. footbibliography::
+
+    Examples
+    --------
+    >>> x = np.array([[5, 1], [1, 5], [4, 2], [4, 4], [5, 1]])
+    >>> moocore.hv_contributions(x, ref=(6, 6))
+    array([0., 3., 2., 0., 0.])
+    >>> moocore.hvc_approx(x, ref=(6, 6)).round(2)
+    array([0., 3., 2., 0., 0.])
+
+    """
+    data, _ = asarray_maybe_copy(data)
+    nobj = data.shape[1]
+    ref = atleast_1d_of_length_n(np.array(ref, dtype=float), nobj)
+    if nobj != ref.shape[0]:
+        raise ValueError(
+            f"data and ref need to have the same number of objectives ({nobj} != {ref.shape[0]})"
+        )
+
+    maximise = _parse_maximise(maximise, nobj)
+    maximise = ffi.from_buffer("bool []", maximise)
+    hvc = np.empty(len(data), dtype=float)
+    hvc_p, _ = np1d_to_double_array(hvc)
+    data_p, npoints, nobj = np2d_to_double_array(data)
+    ref = ffi.from_buffer("double []", ref)
+
+    if not is_integer_value(nsamples):
+        raise ValueError(f"nsamples must be an integer value: {nsamples}")
+    nsamples = ffi.cast("uint_fast32_t", nsamples)
+    if method == "DZ2019-MC":
+        if not is_integer_value(seed):
+            seed = np.random.default_rng(seed).integers(
+                2**32 - 2, dtype=np.uint32
+            )
+        seed = ffi.cast("uint32_t", seed)
+        lib.hvc_approx_normal(
+            hvc_p,
+            data_p,
+            nobj,
+            npoints,
+            ref,
+            maximise,
+            nsamples,
+            seed,
+            get_nthreads(nthreads),
+        )
+    elif method == "DZ2019-HW":
+        lib.hvc_approx_hua_wang(
+            hvc_p,
+            data_p,
+            nobj,
+            npoints,
+            ref,
+            maximise,
+            nsamples,
+            get_nthreads(nthreads),
+        )
+    else:
+        raise ValueError(f"Unknown value of method = {method}")
+
+    return hvc
+
+
 def is_nondominated(
     data: ArrayLike,
     maximise: bool | list[bool] = False,
@@ -1371,7 +1796,9 @@ def eaf(
     proposed by :footcite:t:`FonGueLopPaq2011emo`, which have complexity
     :math:`O(m\log m + nm)` in 2D and :math:`O(n^2 m \log m)` in 3D, where
     :math:`n` is the number of input sets and :math:`m` is the total number of
-    input points.
+    input points.  With more than three objectives, a dimension-sweep
+    algorithm solves one EAF problem with one objective less per input point,
+    which is only practical for a moderate number of input points.
 
 
     References
@@ -1433,10 +1860,6 @@ def eaf(
     ncols = data.shape[1]
     if ncols < 2:
         raise ValueError("'data' must have at least 2 columns")
-    if ncols > 3:
-        raise NotImplementedError(
-            "Only 2D or 3D datasets are currently supported for computing the EAF"
-        )
     if len(sets) != data.shape[0]:
         raise ValueError(
             "'sets' must have the same length as the number of rows of 'data'"
@@ -1472,6 +1895,29 @@ def eaf(
     return np.frombuffer(eaf_buf).reshape((eaf_npoints, -1))
 
 
+def _vorob_common(data, sets, ref):
+    data = np.asarray(data, dtype=float)
+    nobj = data.shape[1]
+    if nobj < 2:
+        raise ValueError("'data' must have at least 2 columns")
+    sets = np.asarray(sets)
+    if len(sets) != data.shape[0]:
+        raise ValueError(
+            "'sets' must have the same length as the number of rows of 'data'"
+        )
+    ref = np.array(ref, dtype=float, ndmin=1)
+    if len(ref) == 1:
+        ref = np.full(nobj, ref[0])
+    elif len(ref) != nobj:
+        raise ValueError(
+            f"data and ref need to have the same number of objectives ({nobj} != {len(ref)})"
+        )
+    # The C code expects the points of each set to be contiguous.
+    order = np.argsort(sets, kind="stable")
+    _, cumsizes = np.unique(sets[order], return_counts=True)
+    return data[order], np.cumsum(cumsizes), ref
+
+
 def vorob_t(data: ArrayLike, /, sets: ArrayLike, *, ref: ArrayLike) -> dict:
     r"""Compute Vorob'ev threshold and expectation.
 
@@ -1502,32 +1948,33 @@ def vorob_t(data: ArrayLike, /, sets: ArrayLike, *, ref: ArrayLike) -> dict:
     >>> res["threshold"]
     44.140625
     >>> res["avg_hyp"]
-    8943.333191728081
+    8943.33319172808
     >>> res["ve"].shape
     (213, 2)
     """
-    data = np.asarray(data, dtype=float)
-    nobj = data.shape[1]
-    if nobj < 2:
-        raise ValueError("'data' must have at least 2 columns")
-
-    hv_ind = Hypervolume(ref=ref)
-    avg_hyp = np.mean(apply_within_sets(data, sets, hv_ind))
-    prev_hyp = diff = np.inf  # hypervolume of quantile at previous step
-    a = 0.0
-    b = 100.0
-    while diff != 0:
-        c = (a + b) / 2.0
-        eaf_res = eaf(data, sets=sets, percentiles=c)[:, :nobj]
-        tmp = hv_ind(eaf_res)
-        if tmp > avg_hyp:
-            a = c
-        else:
-            b = c
-        diff = prev_hyp - tmp
-        prev_hyp = tmp
-
-    return dict(threshold=c, ve=eaf_res, avg_hyp=float(avg_hyp))
+    data, cumsizes, ref = _vorob_common(data, sets, ref)
+    data_p, npoints, nobj = np2d_to_double_array(data)
+    cumsizes_p, ncumsizes = np1d_to_int_array(cumsizes)
+    ref_p = ffi.from_buffer("double []", ref)
+    ve_npoints = ffi.new("int *")
+    threshold = ffi.new("double *")
+    avg_hyp = ffi.new("double *")
+    ve_p = lib.vorob_t(
+        ve_npoints,
+        threshold,
+        avg_hyp,
+        data_p,
+        nobj,
+        cumsizes_p,
+        ncumsizes,
+        ref_p,
+    )
+    ve_npoints = ve_npoints[0]
+    ve_buf = ffi.buffer(
+        ve_p, ffi.sizeof("double") * ve_npoints * data.shape[1]
+    )
+    ve = np.frombuffer(ve_buf).reshape((ve_npoints, -1))
+    return dict(threshold=threshold[0], ve=ve, avg_hyp=avg_hyp[0])
 
 
 def vorob_dev(
@@ -1568,30 +2015,54 @@ def vorob_dev(
     >>> CPFs = moocore.get_dataset("CPFs.txt")
     >>> vd = moocore.vorob_dev(CPFs[:, :-1], sets=CPFs[:, -1], ref=(2, 200))
     >>> vd
-    3017.12989402326
+    3017.12989402327
 
     """
-    data = np.asarray(data, dtype=float)
-    nobj = data.shape[1]
-    if nobj < 2:
-        raise ValueError("'data' must have at least 2 columns")
-
-    # Hypervolume of the symmetric difference between A and B:
-    # 2 * H(AUB) - H(A) - H(B)
-    hv_ind = Hypervolume(ref=ref)
-
     if ve is None:
-        res = vorob_t(data, sets=sets, ref=ref)
-        ve = res["ve"]
-        h1 = res["avg_hyp"]
-    else:
-        h1 = np.mean(apply_within_sets(data, sets, hv_ind))
+        ve = vorob_t(data, sets=sets, ref=ref)["ve"]
+    data, cumsizes, ref = _vorob_common(data, sets, ref)
+    ve = np.asarray(ve, dtype=float)
+    if ve.ndim != 2 or ve.shape[1] != data.shape[1]:
+        raise ValueError(
+            f"'ve' must have the same number of columns as 'data' ({data.shape[1]})"
+        )
+    data_p, _, nobj = np2d_to_double_array(data)
+    cumsizes_p, ncumsizes = np1d_to_int_array(cumsizes)
+    ve_p, ve_npoints, _ = np2d_to_double_array(ve)
+    ref_p = ffi.from_buffer("double []", ref)
+    return lib.vorob_dev(
+        data_p, nobj, cumsizes_p, ncumsizes, ve_p, ve_npoints, ref_p
+    )
+
 
-    h2 = hv_ind(ve)
-    vd = 2 * np.mean(
-        apply_within_sets(data, sets, lambda g: hv_ind(np.vstack((g, ve))))
+def _eafdiff_data(x, y, intervals, maximise):
+    x = np.asarray(x, dtype=float)
+    y = np.asarray(y, dtype=float)
+    assert x.shape[1] == y.shape[1], (
+        "'x' and 'y' must have the same number of columns"
     )
-    return float(vd - h1 - h2)
+    nobj = x.shape[1] - 1
+    assert nobj == 2
+    # The C code expects points within a set to be contiguous.
+    x = x[x[:, -1].argsort(), :]
+    y = y[y[:, -1].argsort(), :]
+    _, cumsizes_x = np.unique(x[:, -1], return_counts=True)
+    _, cumsizes_y = np.unique(y[:, -1], return_counts=True)
+    cumsizes_x = np.cumsum(cumsizes_x)
+    cumsizes_y = np.cumsum(cumsizes_y)
+    cumsizes = np.concatenate((cumsizes_x, cumsizes_x[-1] + cumsizes_y))
+    nsets = len(cumsizes)
+
+    data = np.vstack((x[:, :-1], y[:, :-1]))
+    if maximise.any():
+        data[:, maximise] = -data[:, maximise]
+
+    if intervals is None:
+        intervals = int(nsets / 2.0)
+    else:
+        assert is_integer_value(intervals)
+        intervals = min(intervals, int(nsets / 2.0))
+    return data, cumsizes, intervals
 
 
 def eafdiff(
@@ -1695,34 +2166,9 @@ def eafdiff(
            [ 4. ,  2.5,  inf,  3. ,  1. ]])
 
     """
-    x = np.asarray(x, dtype=float)
-    y = np.asarray(y, dtype=float)
-    assert x.shape[1] == y.shape[1], (
-        "'x' and 'y' must have the same number of columns"
-    )
-    nobj = x.shape[1] - 1
-    assert nobj == 2
+    nobj = np.shape(x)[1] - 1
     maximise = _parse_maximise(maximise, nobj=nobj)
-    # The C code expects points within a set to be contiguous.
-    x = x[x[:, -1].argsort(), :]
-    y = y[y[:, -1].argsort(), :]
-    _, cumsizes_x = np.unique(x[:, -1], return_counts=True)
-    _, cumsizes_y = np.unique(y[:, -1], return_counts=True)
-    cumsizes_x = np.cumsum(cumsizes_x)
-    cumsizes_y = np.cumsum(cumsizes_y)
-    cumsizes = np.concatenate((cumsizes_x, cumsizes_x[-1] + cumsizes_y))
-    nsets = len(cumsizes)
-
-    data = np.vstack((x[:, :-1], y[:, :-1]))
-    if maximise.any():
-        data[:, maximise] = -data[:, maximise]
-
-    if intervals is None:
-        intervals = int(nsets / 2.0)
-    else:
-        assert is_integer_value(intervals)
-        intervals = min(intervals, int(nsets / 2.0))
-
+    data, cumsizes, intervals = _eafdiff_data(x, y, intervals, maximise)
     data_p, _, nobj_int = np2d_to_double_array(data)
     cumsizes_p, nsets = np1d_to_int_array(cumsizes)
     eaf_npoints = ffi.new("int *")
@@ -1810,7 +2256,7 @@ def whv_rect(
     .. seealso:: For details about parameters, return value and examples, see :func:`total_whv_rect`.
 
     .. warning::
-        The current implementation only supports 2 objectives.
+        The current implementation only supports 2 and 3 objectives.
 
     Returns
     -------
@@ -1823,11 +2269,14 @@ def whv_rect(
     """
     x = np.asarray(x, dtype=float)
     nobj = x.shape[1]
-    if nobj != 2:
-        raise NotImplementedError("Only 2D datasets are currently supported")
-    if rectangles.shape[1] != 5:
+    if nobj not in (2, 3):
+        raise NotImplementedError(
+            "Only 2D and 3D datasets are currently supported"
+        )
+    rectangles = np.asarray(rectangles, dtype=float)
+    if rectangles.shape[1] != 2 * nobj + 1:
         raise ValueError(
-            "Invalid number of columns in 'rectangles' (should be 5)"
+            f"Invalid number of columns in 'rectangles' (should be {2 * nobj + 1})"
         )
 
     ref = atleast_1d_of_length_n(np.asarray(ref, dtype=float), nobj)
@@ -1847,10 +2296,104 @@ def whv_rect(
     #     else:
     #         pos = np.flatnonzero(maximise) + [0,2]
     #         rectangles[:, pos] = -rectangles[:, pos]
+    if nobj == 3:
+        return lib.rect_weighted_hv3d(
+            x, npoints, rectangles, rectangles_nrow, ref
+        )
     hv = lib.rect_weighted_hv2d(x, npoints, rectangles, rectangles_nrow, ref)
     return hv
 
 
+def whv_eafdiff(
+    data: ArrayLike,
+    /,
+    x: ArrayLike,
+    y: ArrayLike,
+    *,
+    ref: ArrayLike,
+    intervals: int | None = None,
+    maximise: bool | list[bool] = False,
+) -> tuple[float, float]:
+    """Compute weighted hypervolume using the EAF differences as weights.
+
+    This is equivalent to calling :func:`whv_rect` with the rectangles
+    returned by :func:`eafdiff` with ``rectangles=True``, once with the
+    rectangles with positive color and once with the rectangles with negative
+    color (as absolute values), but the rectangles are never created, which
+    saves a lot of time and memory when there are many of them.
+
+    .. warning::
+        The current implementation only supports 2 objectives.
+
+    Parameters
+    ----------
+    data :
+        Numpy array of numerical values, where each row gives the coordinates of a point.
+
+    x, y :
+       Numpy matrices corresponding to the input data of left and right sides,
+       respectively, as in :func:`eafdiff`.
+
+    ref :
+        Reference point as a 1D vector. Must be same length as a single row in ``data``.
+
+    intervals :
+       The absolute range of the differences :math:`[0, 1]` is partitioned into the number of intervals provided.
+
+    maximise :
+        Whether the objectives must be maximised instead of minimised.
+        Either a single boolean value that applies to all objectives or a list of booleans, with one value per objective.
+        Also accepts a 1D numpy array with values 0 or 1 for each objective.
+
+    Returns
+    -------
+        The weighted hypervolume in the regions where ``x`` is better than
+        ``y`` and in the regions where ``y`` is better than ``x``.
+
+    See Also
+    --------
+    eafdiff, whv_rect
+
+    Examples
+    --------
+    >>> from io import StringIO
+    >>> A1 = moocore.read_datasets(StringIO("3 2\\n2 3\\n\\n2.5 1\\n1 2\\n\\n1 2"))
+    >>> A2 = moocore.read_datasets(
+    ...     StringIO("4 2.5\\n3 3\\n2.5 3.5\\n\\n3 3\\n2.5 3.5\\n\\n2 1")
+    ... )
+    >>> moocore.whv_eafdiff([[1, 1]], A1, A2, ref=6)
+    (17.5, 0.5)
+
+    The same values computed from the rectangles:
+
+    >>> rectangles = moocore.eafdiff(A1, A2, rectangles=True)
+    >>> moocore.whv_rect([[1, 1]], rectangles[rectangles[:, -1] > 0], ref=6)
+    17.5
+
+    """
+    data = np.asarray(data, dtype=float)
+    nobj = data.shape[1]
+    if nobj != 2:
+        raise NotImplementedError("Only 2D datasets are currently supported")
+    maximise = _parse_maximise(maximise, nobj=nobj)
+    ref = atleast_1d_of_length_n(np.asarray(ref, dtype=float), nobj)
+    eaf_data, cumsizes, intervals = _eafdiff_data(x, y, intervals, maximise)
+    if maximise.any():
+        data = data.copy()
+        data[:, maximise] = -data[:, maximise]
+        ref = np.where(maximise, -ref, ref)
+
+    data_p, npoints, _ = np2d_to_double_array(data)
+    eaf_data_p, _, _ = np2d_to_double_array(eaf_data)
+    cumsizes_p, nsets = np1d_to_int_array(cumsizes)
+    ref_p = ffi.from_buffer("double []", ref)
+    whv = ffi.new("double [2]")
+    lib.eafdiff_whv(
+        whv, data_p, npoints, eaf_data_p, cumsizes_p, nsets, intervals, ref_p
+    )
+    return whv[0], whv[1]
+
+
 def get_ideal(x, maximise):
     # FIXME: Is there a better way to do this?
     lower = x.min(axis=0)
@@ -1877,7 +2420,7 @@ def total_whv_rect(
     details of the computation are given by :footcite:t:`DiaLop2020ejor`.
 
     .. warning::
-        The current implementation only supports 2 objectives.
+        The current implementation only supports 2 and 3 objectives.
 
     Parameters
     ----------
@@ -1888,6 +2431,9 @@ def total_whv_rect(
     rectangles :
         Weighted rectangles that will bias the computation of the hypervolume.
         Maybe generated by :func:`eafdiff()` with  ``rectangles=True`` or by :func:`choose_eafdiff()`.
+        Each row gives the lower corner, the upper corner and the weight of
+        one rectangle, that is, 5 columns in 2D and 7 columns (boxes) in 3D.
+        The weights of overlapping rectangles add up.
 
     ref :
         Reference point as a 1D vector. Must be same length as a single row in  ``x``.
@@ -1937,14 +2483,25 @@ def total_whv_rect(
     >>> total_whv_rect([[1, 2]], rectangles, ref=6, ideal=1)
     37.5
 
+    In 3D, each row gives a box:
+
+    >>> boxes = np.array([[1.0, 1.0, 1.0, 3.0, 3.0, 3.0, 2]])
+    >>> whv_rect([[2, 2, 2]], boxes, ref=6)
+    2.0
+    >>> whv_rect([[2, 2, 2], [1, 3, 1]], boxes, ref=[6, 6, 2.5])
+    1.0
+
     """
     x = np.asarray(x, dtype=float)
     nobj = x.shape[1]
-    if nobj != 2:
-        raise NotImplementedError("Only 2D datasets are currently supported")
-    if rectangles.shape[1] != 5:
+    if nobj not in (2, 3):
+        raise NotImplementedError(
+            "Only 2D and 3D datasets are currently supported"
+        )
+    rectangles = np.asarray(rectangles, dtype=float)
+    if rectangles.shape[1] != 2 * nobj + 1:
         raise ValueError(
-            "Invalid number of columns in 'rectangles' (should be 5)"
+            f"Invalid number of columns in 'rectangles' (should be {2 * nobj + 1})"
         )
     if scalefactor <= 0 or scalefactor > 1:
         raise ValueError("'scalefactor' must be within (0,1]")
@@ -1968,8 +2525,9 @@ def largest_eafdiff(
     ref: ArrayLike,
     *,
     maximise: bool | list[bool] = False,
-    intervals: int = 5,
+    intervals: int | None = 5,
     ideal: ArrayLike = None,
+    nthreads: int | None = None,
 ) -> tuple[tuple[int, int], float]:
     """Identify largest EAF differences.
 
@@ -1994,10 +2552,14 @@ def largest_eafdiff(
 
     intervals :
        The absolute range of the differences :math:`[0, 1]` is partitioned into the number of intervals provided.
+       For each pair, it is at most half the number of sets of both datasets, which is also the value used if ``None``, as in :func:`eafdiff`.
 
     ideal :
         Ideal point as a vector of numerical values.  If ``None``, it is calculated as minimum (or maximum if maximising that objective) of each objective in the input data.
 
+    nthreads :
+        Maximum number of threads used by this call. See :func:`hv_approx`.
+
 
     Returns
     -------
@@ -2012,6 +2574,14 @@ def largest_eafdiff(
     --------
     eafdiff, whv_rect
 
+    Notes
+    -----
+    The attainment surfaces of each dataset are computed only once and the
+    pairs are evaluated in parallel.  The value of a pair is the minimum of
+    the area within ``ideal`` and ``ref`` where the EAF of one dataset
+    exceeds the EAF of the other by at least ``1 / intervals``, which is what
+    :func:`whv_rect` computes from the rectangles returned by :func:`eafdiff`.
+
     References
     ----------
     .. footbibliography::
@@ -2047,6 +2617,12 @@ def largest_eafdiff(
     n = len(x)
     if n == 0:
         raise ValueError("Empty list")
+    if n == 1:
+        raise ValueError("At least two datasets are required")
+    if intervals is not None and (
+        not is_integer_value(intervals) or intervals < 1
+    ):
+        raise ValueError(f"intervals must be a positive integer: {intervals}")
     x = [np.asarray(z, dtype=float) for z in x]
     nobj = x[0].shape[1] - 1
     if nobj != 2:
@@ -2062,38 +2638,44 @@ def largest_eafdiff(
             ),
             maximise=maximise,
         )
+    ideal = atleast_1d_of_length_n(
+        np.asarray(ideal, dtype=float).ravel(), nobj
+    )
+    ref = atleast_1d_of_length_n(np.asarray(ref, dtype=float), nobj)
 
-    ideal = ideal.reshape(1, -1)
-
-    best_value = 0
-    for a in range(n - 1):
-        for b in range(a + 1, n):
-            diff = eafdiff(
-                x[a],
-                x[b],
-                intervals=intervals,
-                maximise=maximise,
-                rectangles=True,
-            )
-            # Set color to 1
-            a_rectangles = diff[diff[:, -1] >= 1, :]
-            a_rectangles[:, -1] = 1
-            a_value = whv_rect(
-                ideal, rectangles=a_rectangles, ref=ref, maximise=maximise
-            )
-
-            b_rectangles = diff[diff[:, -1] <= -1, :]
-            b_rectangles[:, -1] = 1
-            b_value = whv_rect(
-                ideal, rectangles=b_rectangles, ref=ref, maximise=maximise
-            )
-
-            value = min(a_value, b_value)
-            if value > best_value:
-                best_value = value
-                best_pair = (a, b)
-
-    return best_pair, best_value
+    # The C code expects points within a set to be contiguous.
+    x = [z[z[:, -1].argsort(kind="stable"), :] for z in x]
+    nruns = np.array([len(np.unique(z[:, -1])) for z in x])
+    if intervals is None:
+        # The C code limits intervals to half the number of sets of each pair.
+        intervals = nruns.max()
+    cumsizes = np.cumsum(
+        np.concatenate([np.unique(z[:, -1], return_counts=True)[1] for z in x])
+    )
+    data = np.concatenate([z[:, :-1] for z in x])
+    if maximise.any():
+        data[:, maximise] = -data[:, maximise]
+        ideal = np.where(maximise, -ideal, ideal)
+        ref = np.where(maximise, -ref, ref)
+
+    data_p, _, _ = np2d_to_double_array(data)
+    cumsizes_p, _ = np1d_to_int_array(cumsizes)
+    nruns_p, n = np1d_to_int_array(nruns)
+    ideal_p = ffi.from_buffer("double []", ideal)
+    ref_p = ffi.from_buffer("double []", ref)
+    best_pair = ffi.new("int [2]")
+    best_value = lib.largest_eafdiff(
+        best_pair,
+        data_p,
+        cumsizes_p,
+        nruns_p,
+        n,
+        int(intervals),
+        ideal_p,
+        ref_p,
+        get_nthreads(nthreads),
+    )
+    return (best_pair[0], best_pair[1]), best_value
 
 
 def whv_hype(
@@ -2108,14 +2690,14 @@ def whv_hype(
     seed: int | np.random.Generator | None = None,
     mu: float | ArrayLike | None = None,
 ) -> float:
-    r"""Approximation of the (weighted) hypervolume by Monte-Carlo sampling (2D only).
+    r"""Approximation of the (weighted) hypervolume by Monte-Carlo sampling.
 
     Return an estimation of the hypervolume of the space dominated by the input
     data following the procedure described by :footcite:t:`AugBadBroZit2009gecco`. A weight
     distribution describing user preferences may be specified.
 
     .. warning::
-        The current implementation only supports 2 objectives.
+        The ``'point'`` and ``'exponential'`` distributions only support 2 objectives.
 
     Parameters
     ----------
@@ -2214,8 +2796,10 @@ def whv_hype(
     # something like [10, 10] then numpy would interpret it as an int array.
     data, data_copied = asarray_maybe_copy(data)
     nobj = data.shape[1]
-    if nobj != 2:
-        raise NotImplementedError("Only 2D datasets are currently supported")
+    if dist != "uniform" and nobj != 2:
+        raise NotImplementedError(
+            f"Only 2D datasets are currently supported with dist = '{dist}'"
+        )
 
     ref = atleast_1d_of_length_n(np.asarray(ref, dtype=float), nobj)
     ideal = atleast_1d_of_length_n(np.asarray(ideal, dtype=float), nobj)
@@ -2243,7 +2827,9 @@ def whv_hype(
     nsamples = ffi.cast("int", nsamples)
 
     if dist == "uniform":
-        hv = lib.whv_hype_unif(data_p, npoints, ideal, ref, nsamples, seed)
+        hv = lib.whv_hype_unif(
+            data_p, npoints, nobj, ideal, ref, nsamples, seed
+        )
     elif dist == "exponential":
         mu = ffi.cast("double", mu)
         hv = lib.whv_hype_expo(data_p, npoints, ideal, ref, nsamples, seed, mu)
@@ -1,3 +1,5 @@
+import os
+
 import numpy as np
 from ._libmoocore import ffi
 
@@ -8,8 +10,8 @@ def get1_and_is_copied(x, x_):
 
 
 def asarray_maybe_copy(x, dtype=float):
-    """Convert to numpy array of dtype=float and detect copies."""
-    return get1_and_is_copied(np.asarray(x, dtype=dtype), x)
+    """Convert to C-contiguous numpy array of dtype=float and detect copies."""
+    return get1_and_is_copied(np.asarray(x, dtype=dtype, order="C"), x)
 
 
 def unique_nosort(array, **kwargs):
@@ -23,18 +25,28 @@ def unique_nosort(array, **kwargs):
 
 
 def np2d_to_double_array(x):
+    """Return a C pointer to the data of a 2D array and its shape.
+
+    A C-contiguous array of dtype float64 is passed to C without copying.  Any
+    other input is converted once.  The C functions that receive the pointer
+    do not modify the data unless documented otherwise.
+
+    """
     nrows = ffi.cast("int", x.shape[0])
     ncols = ffi.cast("int", x.shape[1])
-    # FIXME: This may cause an unexpected copy. Make this an assert and force
-    # the caller to enforce it if needed.
-    x = np.ascontiguousarray(x)
+    x = np.ascontiguousarray(x, dtype=float)
     x = ffi.from_buffer("double []", x)
     return x, nrows, ncols
 
 
 def np1d_to_double_array(x):
+    """Return a C pointer to the data of a 1D array and its size.
+
+    See :func:`np2d_to_double_array`.
+
+    """
     size = ffi.cast("int", x.shape[0])
-    x = np.ascontiguousarray(x)
+    x = np.ascontiguousarray(x, dtype=float)
     x = ffi.from_buffer("double []", x)
     return x, size
 
@@ -69,3 +81,25 @@ def is_integer_value(n):
         return False
     except TypeError:
         return False
+
+
+def get_nthreads(nthreads=None):
+    """Return the number of threads used by the C functions that run in parallel.
+
+    ``None`` uses the first value of the environment variable
+    ``OMP_NUM_THREADS``, if set, otherwise the number of CPUs that the process
+    may use, which takes into account its CPU affinity.
+
+    """
+    if nthreads is None:
+        omp = os.environ.get("OMP_NUM_THREADS", "").split(",")[0].strip()
+        if omp.isdigit() and int(omp) > 0:
+            return int(omp)
+        if hasattr(os, "process_cpu_count"):  # Python >= 3.13
+            return os.process_cpu_count() or 1
+        if hasattr(os, "sched_getaffinity"):
+            return len(os.sched_getaffinity(0)) or 1
+        return os.cpu_count() or 1
+    if not is_integer_value(nthreads) or nthreads < 1:
+        raise ValueError(f"nthreads must be a positive integer: {nthreads}")
+    return int(nthreads)
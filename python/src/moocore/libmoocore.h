@@ -1,8 +1,8 @@
 /* From stdlib.h */
 void free(void *);
-int read_datasets(const char * filename, double **data_p, int *ncols_p, int *datasize_p);
+int read_datasets(const char * filename, double **data_p, int *ncols_p, int *datasize_p, int nthreads);
 double fpli_hv(const double *data, int d, int n, const double *ref);
-void hv_contributions (double *hvc, double *points, int dim, int size, const double * ref);
+void hv_contributions (double *hvc, const double *points, int dim, int size, const double * ref);
 double IGD (const double *data, int nobj, int npoints, const double *ref, int ref_size, const bool * maximise);
 double IGD_plus (const double *data, int nobj, int npoints, const double *ref, int ref_size, const bool * maximise);
 double avg_Hausdorff_dist (const double *data, int nobj, int npoints, const double *ref, int ref_size, const bool * maximise, unsigned int p);
@@ -12,16 +12,27 @@ bool * is_nondominated (const double * data, int nobj, size_t npoint, const bool
 int * pareto_rank (const double *points, int dim, int size);
 void agree_normalise (double *data, int nobj, int npoint, const bool * maximise,
                       const double lower_range, const double upper_range, const double *lbound, const double *ubound);
-double * eaf_compute_matrix (int *eaf_npoints, double * data, int nobj, const int *cumsizes,
+double * eaf_compute_matrix (int *eaf_npoints, const double * data, int nobj, const int *cumsizes,
                              int nruns, const double * percentile, int nlevels);
-double * eafdiff_compute_rectangles(int *eaf_npoints, double * data, int nobj,
+double * eafdiff_compute_rectangles(int *eaf_npoints, const double * data, int nobj,
                                     const int *cumsizes, int nruns, int intervals);
 double *
-eafdiff_compute_matrix(int *eaf_npoints, double * data, int nobj,
+eafdiff_compute_matrix(int *eaf_npoints, const double * data, int nobj,
                        const int *cumsizes, int nruns, int intervals);
+void eafdiff_whv (double *whv, const double *points, int npoints,
+                  const double *data, const int *cumsizes, int nruns,
+                  int intervals, const double *ref);
+double largest_eafdiff (int *best, const double *data, const int *cumsizes,
+                        const int *nruns, int n, int intervals,
+                        const double *lower, const double *upper, int nthreads);
+double * vorob_t(int *ve_npoints, double *threshold, double *avg_hyp,
+                 const double *data, int nobj, const int *cumsizes, int nruns,
+                 const double *ref);
+double vorob_dev(const double *data, int nobj, const int *cumsizes, int nruns,
+                 const double *ve, int ve_npoints, const double *ref);
 
 /* whv_hype.h */
-double whv_hype_unif(const double *points, int npoints,
+double whv_hype_unif(const double *points, int npoints, int nobj,
                      const double *ideal, const double *ref,
                      int nsamples, uint32_t seed);
 double whv_hype_expo(const double *points, int npoints,
@@ -31,15 +42,27 @@ double whv_hype_gaus(const double *points, int npoints,
                      const double *ideal, const double *ref,
                      int nsamples, uint32_t seed, const double *mu);
 /* whv.h */
-double rect_weighted_hv2d(double *data, int n, double * rectangles, int rectangles_nrow, const double * reference);
+double rect_weighted_hv2d(const double *data, int n, const double *rectangles, int rectangles_nrow, const double * reference);
+double rect_weighted_hv3d(const double *data, int n, const double *rectangles, int rectangles_nrow, const double *reference);
 
 /* hvapprox.h */
 double hv_approx_hua_wang(const double * data, int nobjs, int npoints,
                           const double * ref, const bool * maximise,
-                          uint_fast32_t nsamples);
+                          uint_fast32_t nsamples, int nthreads);
 double hv_approx_normal(const double * data, int nobjs, int npoints,
                         const double * ref, const bool * maximise,
-                        uint_fast32_t nsamples, uint32_t seed);
+                        uint_fast32_t nsamples, uint32_t seed, int nthreads);
+double hv_approx_normal_adaptive(double * std_error, uint_fast32_t * nsamples_used,
+                                 const double * data, int nobjs, int npoints,
+                                 const double * ref, const bool * maximise,
+                                 double rel_error, double z, uint_fast32_t max_nsamples,
+                                 uint32_t seed, int nthreads);
+void hvc_approx_hua_wang(double * hvc, const double * data, int nobjs, int npoints,
+                         const double * ref, const bool * maximise,
+                         uint_fast32_t nsamples, int nthreads);
+void hvc_approx_normal(double * hvc, const double * data, int nobjs, int npoints,
+                       const double * ref, const bool * maximise,
+                       uint_fast32_t nsamples, uint32_t random_seed, int nthreads);
 
 /*
 typedef ... hype_sample_dist;
@@ -6,6 +6,7 @@ from numpy.testing import (
     assert_allclose,
 )
 import math
+import sys
 
 import moocore
 
@@ -55,6 +56,18 @@ def test_read_datasets_data(test_datapath):
         check_testdata(test_datapath(test), expected_name, expected_shape)
 
 
+def test_read_datasets_gzip(test_datapath, tmp_path):
+    import gzip
+
+    filename = test_datapath("input1.dat")
+    gzname = tmp_path / "input1.dat.gz"
+    with open(filename, "rb") as fsrc, gzip.open(gzname, "wb") as fdst:
+        fdst.write(fsrc.read())
+    assert_array_equal(
+        moocore.read_datasets(gzname), moocore.read_datasets(filename)
+    )
+
+
 def test_read_datasets_badname():
     """Check that the `moocore.read_datasets()` functions fails correctly after a bad file name is input."""
     with pytest.raises(Exception) as expt:
@@ -77,6 +90,40 @@ def test_read_datasets_errorcode(test_datapath):
     assert expt.value.message == "ERROR_COLUMNS"
 
 
+def test_read_datasets_binary(test_datapath, tmp_path):
+    """Check that a file written in binary format gives back the same data."""
+    x = moocore.get_dataset("wrots_l10w100_dat.xz")
+    filename = tmp_path / "wrots_l10w100.bin"
+    moocore.write_datasets_binary(filename, x[:, :-1], x[:, -1])
+    data, sets = moocore.read_datasets_binary(filename)
+    assert isinstance(data, np.memmap)
+    assert_array_equal(data, x[:, :-1])
+    assert_array_equal(sets, x[:, -1])
+    assert_array_equal(moocore.read_datasets(filename), x)
+
+    with pytest.raises(moocore.ReadDatasetsError) as expt:
+        moocore.read_datasets_binary(test_datapath("column_error.dat"))
+    assert expt.value.message == "ERROR_CONVERSION"
+
+    # Invalid headers are rejected by both readers: a different byte order,
+    # and points without sets.
+    import struct
+
+    raw = filename.read_bytes()
+    nobj, nsets, npoints = struct.unpack_from("=IIQ", raw, 16)
+    swapped = ">" if sys.byteorder == "little" else "<"
+    for header in [
+        struct.pack(swapped + "IIIIQ", 0x01020304, 1, nobj, nsets, npoints),
+        struct.pack("=IIIIQ", 0x01020304, 1, nobj, 0, npoints),
+    ]:
+        bad = tmp_path / "bad.bin"
+        bad.write_bytes(raw[:8] + header + raw[32:])
+        for read in [moocore.read_datasets_binary, moocore.read_datasets]:
+            with pytest.raises(moocore.ReadDatasetsError) as expt:
+                read(bad)
+            assert expt.value.message == "ERROR_CONVERSION"
+
+
 class TestHypervolume:
     """Test hypervolume function."""
 
@@ -335,6 +382,79 @@ def test_eaf(test_datapath):
         )
 
 
+def _eaf_brute_force(x, sets):
+    """Minimal points of each level of the EAF over the grid of coordinates."""
+    nobj = x.shape[1]
+    runs = np.unique(sets)
+    grid = np.array(
+        np.meshgrid(*[np.unique(x[:, j]) for j in range(nobj)], indexing="ij")
+    ).reshape(nobj, -1).T
+    count = np.zeros(len(grid), dtype=int)
+    for r in runs:
+        count += (x[sets == r][None, :, :] <= grid[:, None, :]).all(-1).any(-1)
+    res = []
+    for level in range(1, len(runs) + 1):
+        z = grid[count >= level]
+        below = (z[:, None, :] <= z[None, :, :]).all(-1)
+        minimal = below.sum(axis=0) == 1
+        pct = 100.0 * level / len(runs)
+        res += [(*p, pct) for p in z[minimal]]
+    return np.array(sorted(res))
+
+
+@pytest.mark.parametrize("nobj", [4, 5])
+def test_eaf_nd(nobj):
+    rng = np.random.default_rng(nobj)
+    sets = np.repeat(np.arange(4), [3, 5, 4, 2])
+    # Few distinct values, so that there are many ties.
+    x = rng.integers(0, 4, size=(len(sets), nobj)).astype(float)
+    eaf = moocore.eaf(x, sets=sets)
+    assert eaf.shape[1] == nobj + 1
+    assert_array_equal(np.array(sorted(map(tuple, eaf))), _eaf_brute_force(x, sets))
+
+
+@pytest.mark.parametrize("nobj", [2, 3])
+def test_vorob(nobj):
+    rng = np.random.default_rng(42)
+    sets = rng.permutation(np.repeat(np.arange(10), 8))
+    x = rng.random((len(sets), nobj))
+    x = moocore.filter_dominated_within_sets(np.column_stack((x, sets)))
+    x, sets = x[:, :-1], x[:, -1]
+    ref = np.full(nobj, 1.1)
+    res = moocore.vorob_t(x, sets=sets, ref=ref)
+
+    # Bisection over the percentiles, recomputing the EAF at each step.
+    hv_ind = moocore.Hypervolume(ref=ref)
+    avg_hyp = np.mean(moocore.apply_within_sets(x, sets, hv_ind))
+    order = np.argsort(sets, kind="stable")
+    prev_hyp = diff = np.inf
+    a, b = 0.0, 100.0
+    while diff != 0:
+        c = (a + b) / 2.0
+        ve = moocore.eaf(x[order], sets=sets[order], percentiles=c)[:, :nobj]
+        tmp = hv_ind(ve)
+        if tmp > avg_hyp:
+            a = c
+        else:
+            b = c
+        diff = prev_hyp - tmp
+        prev_hyp = tmp
+
+    assert res["threshold"] == c
+    assert_allclose(res["avg_hyp"], avg_hyp)
+    assert_array_equal(res["ve"], ve)
+    vd = 2 * np.mean(
+        moocore.apply_within_sets(x, sets, lambda g: hv_ind(np.vstack((g, ve))))
+    )
+    assert_allclose(
+        moocore.vorob_dev(x, sets=sets, ref=ref), vd - avg_hyp - hv_ind(ve)
+    )
+    assert_allclose(
+        moocore.vorob_dev(x, sets=sets, ref=ref, ve=ve),
+        moocore.vorob_dev(x, sets=sets, ref=ref),
+    )
+
+
 def test_get_dataset_path():
     with pytest.raises(Exception) as expt:
         moocore.get_dataset_path("notavailable")
@@ -359,6 +479,215 @@ def test_get_dataset_path():
 # FIXME add more tests including intervals
 
 
+@pytest.mark.parametrize("intervals", [1, 3, 5, None])
+def test_largest_eafdiff(intervals):
+    rng = np.random.default_rng(intervals)
+    sets = np.repeat(np.arange(1, 5), 6)
+    x = [
+        moocore.filter_dominated_within_sets(
+            np.column_stack((rng.integers(0, 10, size=(len(sets), 2)), sets))
+        )
+        for _ in range(4)
+    ]
+    ref = np.array([8.0, 11.0])
+    ideal = np.zeros((1, 2))
+    values = {}
+    for a in range(len(x) - 1):
+        for b in range(a + 1, len(x)):
+            diff = moocore.eafdiff(
+                x[a], x[b], intervals=intervals, rectangles=True
+            )
+            rect_a = diff[diff[:, -1] >= 1, :]
+            rect_a[:, -1] = 1
+            rect_b = diff[diff[:, -1] <= -1, :]
+            rect_b[:, -1] = 1
+            values[(a, b)] = min(
+                moocore.whv_rect(ideal, rectangles=rect_a, ref=ref),
+                moocore.whv_rect(ideal, rectangles=rect_b, ref=ref),
+            )
+    pair, value = moocore.largest_eafdiff(
+        x, ref=ref, intervals=intervals, ideal=ideal
+    )
+    assert value == max(values.values())
+    assert values[pair] == value
+    for bad in [0, -1, 2.5, "3"]:
+        with pytest.raises(ValueError, match="intervals"):
+            moocore.largest_eafdiff(x, ref=ref, intervals=bad)
+
+
+def test_whv_rect_3d():
+    rng = np.random.default_rng(3)
+    x = rng.integers(0, 6, size=(8, 3))
+    lower = rng.integers(0, 5, size=(6, 3))
+    upper = lower + rng.integers(1, 4, size=(6, 3))
+    color = rng.integers(1, 4, size=(6, 1))
+    boxes = np.hstack((lower, upper, color)).astype(float)
+    ref = np.array([6, 5, 7])
+    # Count the unit cells that are dominated by x and within each box.
+    expected = 0
+    for c in np.ndindex(*ref):
+        if (x <= c).all(axis=1).any():
+            inside = (lower <= c).all(axis=1) & (np.array(c) < upper).all(axis=1)
+            expected += color[inside].sum()
+    assert moocore.whv_rect(x, boxes, ref=ref) == expected
+    with pytest.raises(ValueError):
+        moocore.whv_rect(x, boxes[:, 1:], ref=ref)
+
+
+def test_input_not_modified():
+    rng = np.random.default_rng(7)
+    x = rng.random((20, 2))
+    rect = np.array([[0.0, 0.0, 2.0, 2.0, 1.0], [0.5, 0.5, 0.8, 0.8, 2.0]])
+    x_orig, rect_orig = x.copy(), rect.copy()
+    assert moocore.whv_rect(x, rect, ref=1) == moocore.whv_rect(
+        x_orig[::-1], rect_orig, ref=1
+    )
+    assert_array_equal(x, x_orig)
+    assert_array_equal(rect, rect_orig)
+
+    # Read-only arrays are passed to C without copying.
+    x = rng.random((20, 3))
+    expected = moocore.hv_contributions(x.copy(), ref=1)
+    x.flags.writeable = False
+    assert_array_equal(moocore.hv_contributions(x, ref=1), expected)
+    assert moocore.hypervolume(x, ref=1) == moocore.hypervolume(x.copy(), ref=1)
+
+
+def test_concurrent_calls():
+    from concurrent.futures import ThreadPoolExecutor
+
+    rng = np.random.default_rng(11)
+    # All threads share the same input arrays.
+    x = rng.random((200, 3))
+    sets = np.repeat(np.arange(1, 11), 20)
+
+    def work(_):
+        return (
+            moocore.hypervolume(x, ref=1),
+            moocore.hv_contributions(x, ref=1),
+            moocore.igd_plus(x, ref=x[:20]),
+            moocore.eaf(x, sets=sets),
+        )
+
+    expected = work(None)
+    with ThreadPoolExecutor(max_workers=4) as pool:
+        for res in pool.map(work, range(16)):
+            assert res[0] == expected[0]
+            assert_array_equal(res[1], expected[1])
+            assert res[2] == expected[2]
+            assert_array_equal(res[3], expected[3])
+
+
+def test_nthreads(monkeypatch):
+    x = np.random.default_rng(12).random((50, 3))
+    expected = moocore.hv_approx(x, ref=1, nthreads=1)
+    assert moocore.hv_approx(x, ref=1, nthreads=3) == pytest.approx(expected)
+    assert_array_equal(
+        moocore.hvc_approx(x, ref=1, method="DZ2019-MC", seed=1, nthreads=1),
+        moocore.hvc_approx(x, ref=1, method="DZ2019-MC", seed=1, nthreads=2),
+    )
+    filename = moocore.get_dataset_path("input1.dat")
+    assert_array_equal(
+        moocore.read_datasets(filename, nthreads=1),
+        moocore.read_datasets(filename),
+    )
+    for nthreads in [0, -1, 1.5, "2"]:
+        with pytest.raises(ValueError, match="nthreads"):
+            moocore.hv_approx(x, ref=1, nthreads=nthreads)
+
+    from moocore._utils import get_nthreads
+
+    assert get_nthreads(4) == 4
+    monkeypatch.setenv("OMP_NUM_THREADS", "3,2")
+    assert get_nthreads() == 3
+    monkeypatch.setenv("OMP_NUM_THREADS", "")
+    assert get_nthreads() >= 1
+
+
+@pytest.mark.parametrize("intervals", [1, 2, 5])
+def test_whv_eafdiff(intervals):
+    rng = np.random.default_rng(intervals)
+    sets = np.repeat(np.arange(1, 6), 8)
+    x, y = (
+        moocore.filter_dominated_within_sets(
+            np.column_stack((rng.random((len(sets), 2)), sets))
+        )
+        for _ in range(2)
+    )
+    # whv_rect() does not handle dominated points.
+    data = moocore.filter_dominated(rng.random((5, 2)))
+    ref = np.array([0.9, 1.1])
+    diff = moocore.eafdiff(x, y, intervals=intervals, rectangles=True)
+    pos = diff[diff[:, -1] > 0, :]
+    neg = diff[diff[:, -1] < 0, :]
+    neg[:, -1] = -neg[:, -1]
+    assert_allclose(
+        moocore.whv_eafdiff(data, x, y, ref=ref, intervals=intervals),
+        (
+            moocore.whv_rect(data, pos, ref=ref),
+            moocore.whv_rect(data, neg, ref=ref),
+        ),
+    )
+
+
+@pytest.mark.parametrize("dim", [2, 3, 5])
+def test_whv_hype_uniform(dim):
+    rng = np.random.default_rng(42)
+    x = moocore.filter_dominated(rng.uniform(1, 3, size=(50, dim)))
+    ref = np.full(dim, 4.0)
+    true_hv = moocore.hypervolume(x, ref=ref)
+    appr_hv = moocore.whv_hype(x, ref=ref, ideal=1, nsamples=200000, seed=42)
+    np.testing.assert_allclose(true_hv, appr_hv, rtol=0.01)
+    if dim > 2:
+        with pytest.raises(NotImplementedError):
+            moocore.whv_hype(x, ref=ref, ideal=1, dist="exponential", mu=0.2)
+
+
+@pytest.mark.parametrize("dim", [3, 6])
+def test_hv_approx_adaptive(dim):
+    rng = np.random.default_rng(42)
+    x = moocore.filter_dominated(rng.uniform(size=(50, dim)))
+    true_hv = moocore.hypervolume(x, ref=1.1)
+    hv, std_error, nsamples = moocore.hv_approx_adaptive(
+        x, ref=1.1, rel_error=1e-3, seed=42
+    )
+    assert 1.96 * std_error <= 1e-3 * hv
+    assert abs(hv - true_hv) <= 4 * std_error
+    # Same directions as hv_approx() with the same seed.
+    assert hv == pytest.approx(
+        moocore.hv_approx(
+            x, ref=1.1, nsamples=nsamples, seed=42, method="DZ2019-MC"
+        ),
+        rel=1e-12,
+    )
+    _, _, nsamples = moocore.hv_approx_adaptive(
+        x, ref=1.1, rel_error=1e-6, max_nsamples=10000, seed=42
+    )
+    assert nsamples == 10000
+    for max_nsamples in [0, -1, 2**32, 2**64 + 10]:
+        with pytest.raises(ValueError, match="max_nsamples"):
+            moocore.hv_approx_adaptive(x, ref=1.1, max_nsamples=max_nsamples)
+
+
+@pytest.mark.parametrize("method", ["DZ2019-HW", "DZ2019-MC"])
+@pytest.mark.parametrize("dim", [3, 5])
+def test_hvc_approx(dim, method):
+    rng = np.random.default_rng(42)
+    x = moocore.filter_dominated(rng.uniform(size=(20, dim)))
+    # A dominated point and a point that does not dominate the reference point.
+    x = np.vstack((x, x[0] + 0.01, np.full(dim, 2.0)))
+    true_hvc = moocore.hv_contributions(x, ref=1.1)
+    appr_hvc = moocore.hvc_approx(
+        x, ref=1.1, nsamples=100000, seed=42, method=method
+    )
+    assert appr_hvc[-2:].tolist() == [0, 0]
+    # Monte-Carlo sampling is much less precise than the Hua-Wang sequence.
+    tol = 0.01 if method == "DZ2019-HW" else 0.05
+    np.testing.assert_allclose(
+        true_hvc, appr_hvc, rtol=0, atol=tol * true_hvc.max()
+    )
+
+
 # method="DZ2019-HW" is very slow with dim > 15.
 @pytest.mark.parametrize("dim", range(2, 16))
 def test_hv_approx(dim):
@@ -115,6 +115,11 @@
     if (VAR == NA_INTEGER)                                                 \
         Rf_error ("Argument '" #S "' is not an integer");
 
+#define SEXP_2_REAL(S,VAR)                                                 \
+    double VAR = Rf_asReal(S);                                             \
+    if (ISNAN(VAR))                                                        \
+        Rf_error ("Argument '" #S "' is not a number");
+
 #define SEXP_2_UINT32(S,VAR)                                                  \
     uint32_t VAR = (uint32_t) Rf_asInteger(S);                                \
     if (VAR == NA_INTEGER)                                                    \
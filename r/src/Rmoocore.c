@@ -28,7 +28,7 @@ compute_eaf_helper (SEXP DATA, int nobj, const int * cumsizes, int nruns,
         Rprintf ("}, %d)\n", nlevels);
         );
 
-    eaf_t **eaf = attsurf (data, nobj, cumsizes, nruns, level, nlevels);
+    eaf_t **eaf = attsurf (data, nobj, cumsizes, nruns, level, nlevels, 1);
     free (level);
 
     DEBUG2(
@@ -390,6 +390,19 @@ rect_weighted_hv2d_C(SEXP DATA, SEXP RECTANGLES, SEXP REFERENCE)
     return Rf_ScalarReal(hv);
 }
 
+SEXP
+rect_weighted_hv3d_C(SEXP DATA, SEXP RECTANGLES, SEXP REFERENCE)
+{
+    /* We transpose the matrix before calling this function. */
+    SEXP_2_DOUBLE_MATRIX(DATA, data, nobj, npoint);
+    SEXP_2_DOUBLE_MATRIX(RECTANGLES, rectangles, ncol, rectangles_nrow);
+    SEXP_2_DOUBLE_VECTOR(REFERENCE, reference, reference_len);
+    assert(ncol == 7);
+    assert(reference_len == 3);
+    double hv = rect_weighted_hv3d(data, npoint, rectangles, rectangles_nrow, reference);
+    return Rf_ScalarReal(hv);
+}
+
 #include "whv_hype.h"
 
 SEXP
@@ -400,13 +413,13 @@ whv_hype_C(SEXP DATA, SEXP IDEAL, SEXP REFERENCE, SEXP NSAMPLES, SEXP DIST, SEXP
     SEXP_2_DOUBLE_VECTOR(REFERENCE, reference, reference_len);
     SEXP_2_INT(NSAMPLES, nsamples);
     assert(reference_len == ideal_len);
-    assert(reference_len == 2);
+    assert(reference_len == nobj);
     SEXP_2_STRING(DIST, dist_type);
     SEXP_2_UINT32(SEED, seed);
 
     double hv;
     if (0 == strcmp(dist_type, "uniform")) {
-        hv = whv_hype_unif(data, npoints, ideal, reference, nsamples, seed);
+        hv = whv_hype_unif(data, npoints, nobj, ideal, reference, nsamples, seed);
     } else if (0 == strcmp(dist_type, "exponential")) {
         const double * mu = REAL(MU);
         hv = whv_hype_expo(data, npoints, ideal, reference, nsamples, seed, mu[0]);
@@ -433,7 +446,7 @@ hv_approx_dz2019_mc_C(SEXP DATA, SEXP REFERENCE, SEXP MAXIMISE, SEXP NSAMPLES, S
     assert(nobj == reference_len);
     assert(nobj == maximise_len);
 
-    double hv = hv_approx_normal(data, nobj, npoints, ref, maximise, (uint_fast32_t) nsamples, seed);
+    double hv = hv_approx_normal(data, nobj, npoints, ref, maximise, (uint_fast32_t) nsamples, seed, 1);
     free (maximise);
     return Rf_ScalarReal(hv);
 }
@@ -449,11 +462,78 @@ hv_approx_dz2019_hw_C(SEXP DATA, SEXP REFERENCE, SEXP MAXIMISE, SEXP NSAMPLES)
     assert(nobj == reference_len);
     assert(nobj == maximise_len);
 
-    double hv = hv_approx_hua_wang(data, nobj, npoints, ref, maximise, (uint_fast32_t) nsamples);
+    double hv = hv_approx_hua_wang(data, nobj, npoints, ref, maximise, (uint_fast32_t) nsamples, 1);
     free (maximise);
     return Rf_ScalarReal(hv);
 }
 
+SEXP
+hv_approx_adaptive_C(SEXP DATA, SEXP REFERENCE, SEXP MAXIMISE, SEXP REL_ERROR, SEXP Z,
+                     SEXP MAX_NSAMPLES, SEXP SEED)
+{
+    int nprotected = 0;
+    SEXP_2_DOUBLE_MATRIX(DATA, data, nobj, npoints);
+    SEXP_2_DOUBLE_VECTOR(REFERENCE, ref, reference_len);
+    SEXP_2_LOGICAL_BOOL_VECTOR(MAXIMISE, maximise, maximise_len);
+    SEXP_2_REAL(REL_ERROR, rel_error);
+    SEXP_2_REAL(Z, z);
+    SEXP_2_INT(MAX_NSAMPLES, max_nsamples);
+    SEXP_2_UINT32(SEED, seed);
+
+    assert(nobj == reference_len);
+    assert(nobj == maximise_len);
+
+    double std_error;
+    uint_fast32_t nsamples;
+    new_real_vector(res, 3);
+    res[0] = hv_approx_normal_adaptive(&std_error, &nsamples, data, nobj, npoints, ref, maximise,
+                                       rel_error, z, (uint_fast32_t) max_nsamples, seed, 1);
+    res[1] = std_error;
+    res[2] = (double) nsamples;
+    free (maximise);
+    UNPROTECT (nprotected);
+    return Rexp(res);
+}
+
+SEXP
+hvc_approx_dz2019_mc_C(SEXP DATA, SEXP REFERENCE, SEXP MAXIMISE, SEXP NSAMPLES, SEXP SEED)
+{
+    int nprotected = 0;
+    SEXP_2_DOUBLE_MATRIX(DATA, data, nobj, npoints);
+    SEXP_2_DOUBLE_VECTOR(REFERENCE, ref, reference_len);
+    SEXP_2_LOGICAL_BOOL_VECTOR(MAXIMISE, maximise, maximise_len);
+    SEXP_2_INT(NSAMPLES, nsamples);
+    SEXP_2_UINT32(SEED, seed);
+
+    assert(nobj == reference_len);
+    assert(nobj == maximise_len);
+
+    new_real_vector(hvc, npoints);
+    hvc_approx_normal(hvc, data, nobj, npoints, ref, maximise, (uint_fast32_t) nsamples, seed, 1);
+    free (maximise);
+    UNPROTECT (nprotected);
+    return Rexp(hvc);
+}
+
+SEXP
+hvc_approx_dz2019_hw_C(SEXP DATA, SEXP REFERENCE, SEXP MAXIMISE, SEXP NSAMPLES)
+{
+    int nprotected = 0;
+    SEXP_2_DOUBLE_MATRIX(DATA, data, nobj, npoints);
+    SEXP_2_DOUBLE_VECTOR(REFERENCE, ref, reference_len);
+    SEXP_2_LOGICAL_BOOL_VECTOR(MAXIMISE, maximise, maximise_len);
+    SEXP_2_INT(NSAMPLES, nsamples);
+
+    assert(nobj == reference_len);
+    assert(nobj == maximise_len);
+
+    new_real_vector(hvc, npoints);
+    hvc_approx_hua_wang(hvc, data, nobj, npoints, ref, maximise, (uint_fast32_t) nsamples, 1);
+    free (maximise);
+    UNPROTECT (nprotected);
+    return Rexp(hvc);
+}
+
 #include "epsilon.h"
 #include "igd.h"
 #include "nondominated.h"
@@ -15,6 +15,10 @@ DECLARE_CALL(igd_C, SEXP DATA, SEXP REFERENCE, SEXP MAXIMISE)
 DECLARE_CALL(igd_plus_C, SEXP DATA, SEXP REFERENCE, SEXP MAXIMISE)
 DECLARE_CALL(avg_hausdorff_dist_C, SEXP DATA, SEXP REFERENCE, SEXP MAXIMISE, SEXP P)
 DECLARE_CALL(rect_weighted_hv2d_C, SEXP DATA, SEXP RECTANGLES, SEXP REFERENCE)
+DECLARE_CALL(rect_weighted_hv3d_C, SEXP DATA, SEXP RECTANGLES, SEXP REFERENCE)
 DECLARE_CALL(whv_hype_C, SEXP DATA, SEXP IDEAL, SEXP REFERENCE, SEXP NSAMPLES, SEXP DIST, SEXP SEED, SEXP MU)
 DECLARE_CALL(hv_approx_dz2019_mc_C, SEXP DATA, SEXP REFERENCE, SEXP MAXIMISE, SEXP NSAMPLES, SEXP SEED)
 DECLARE_CALL(hv_approx_dz2019_hw_C, SEXP DATA, SEXP REFERENCE, SEXP MAXIMISE, SEXP NSAMPLES)
+DECLARE_CALL(hv_approx_adaptive_C, SEXP DATA, SEXP REFERENCE, SEXP MAXIMISE, SEXP REL_ERROR, SEXP Z, SEXP MAX_NSAMPLES, SEXP SEED)
+DECLARE_CALL(hvc_approx_dz2019_mc_C, SEXP DATA, SEXP REFERENCE, SEXP MAXIMISE, SEXP NSAMPLES, SEXP SEED)
+DECLARE_CALL(hvc_approx_dz2019_hw_C, SEXP DATA, SEXP REFERENCE, SEXP MAXIMISE, SEXP NSAMPLES)